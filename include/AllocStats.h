@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+
+//==================== 堆分配统计 ====================
+//只在定义 YC_ALLOC_STATS 的基准构建中启用（msbuild /p:YcAllocStats=true）：AllocStats.cpp 替换全局 operator new/delete，
+//每次分配对两个原子计数器做一次 relaxed 累加，统计所有线程的分配次数与字节数。普通构建不替换，计数恒为 0
+//只用于基准（取两次快照相减），不追踪释放
+#ifdef YC_ALLOC_STATS
+constexpr bool ALLOC_STATS_ENABLED=true;
+#else
+constexpr bool ALLOC_STATS_ENABLED=false;
+#endif
+
+struct AllocCounts {
+    size_t count;
+    size_t bytes;
+};
+
+AllocCounts getAllocCounts();
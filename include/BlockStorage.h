@@ -0,0 +1,53 @@
+#pragma once
+#include "Common.h"
+
+#include <cstdint>
+
+//==================== 调色板压缩方块存储 ====================
+//以 CHUNK_SIZE x 16 x CHUNK_SIZE 的区段为单位存储方块：
+//  bits==0 ：整个区段只有一种方块，只保存调色板中的一项
+//  bits==1/2/4 ：按调色板索引位压缩（每个 32 位字存放 32/16/8 个方块）
+//  bits==8 ：每方块一个字节，直接存 BlockType（基线格式，不使用调色板）
+//索引顺序为 (y,z,x)（见 ChunkLayout::indexOf），同一行 x 连续，便于按行解包
+class PalettedContainer {
+public:
+    static constexpr int VOLUME=ChunkLayout::VOLUME;
+    static_assert(VOLUME<=65536,"调色板计数为 16 位");
+
+    PalettedContainer();
+
+    static int indexOf(int x,int y,int z) { return ChunkLayout::indexOf(x,y,z);}
+
+    BlockType get(int index) const;
+    void set(int index,BlockType type);
+
+    //整段填充为同一种方块（释放压缩数据）
+    void fill(BlockType type);
+
+    //从稠密数组（VOLUME 项，按 indexOf 顺序）一次性打包，自动选择最小位宽
+    void load(const BlockType* src);
+    //解包到稠密数组（VOLUME 项）
+    void unpack(BlockType* dst) const;
+
+    //按实际出现的方块重新选择位宽；set 在某项计数归零且能缩小位宽时自动调用
+    void compact();
+
+    bool isUniform() const { return bits==0;}
+    BlockType uniformType() const { return palette[0];}
+    int bitsPerEntry() const { return bits;}
+    int paletteSize() const { return bits==8 ? 0 : paletteCount;}
+
+    //该区段方块数据占用的堆+内联字节数
+    size_t memoryBytes() const;
+
+private:
+    void repack(int newBits);
+    int findOrAddPalette(BlockType type);
+    static int bitsForCount(int distinct);
+
+    uint8_t bits;
+    uint8_t paletteCount;
+    BlockType palette[16];
+    uint16_t counts[16];//bits==1/2/4 时各调色板项出现的次数（至少两项，单项不超过 VOLUME-1）
+    std::vector<uint32_t> data;
+};
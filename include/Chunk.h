@@ -1,75 +1,388 @@
-#pragma once
-#include "Common.h"
-
-struct MeshData {
-    int chunkX;
-    int chunkZ;
-    std::vector<float> verticesByType[NUM_BLOCK_TEXTURES];
-};
-
-class Chunk {
-public:
-    Chunk(int x,int z);
-    ~Chunk();
-
-    void generateTerrain();
-    BlockType getBlock(int x,int y,int z) const; 
-    void setBlock(int x,int y,int z,BlockType type);
-
-    //е GPU 
-    void buildMesh(const glm::vec3* viewDir=nullptr,const glm::vec3* lightDir=nullptr);//,ѡԴ
-
-    // CPU ɣݣڹ߳еã
-    MeshData buildMeshCPU(const glm::vec3* viewDir=nullptr,const glm::vec3* lightDir=nullptr);
-
-    //ϴ GPU߳/OpenGL еã
-    void uploadMeshFromData(const MeshData& data);
-
-    //Ⱦ͸Σдȣ
-    void renderOpaque(Shader &shader,const glm::vec3* lightDir=nullptr);
-
-    //Ⱦ͸Σв͸λƺã
-    //'viewDir'  'cameraPos' ڶ͸дԶ
-    void renderTransparent(Shader &shader,const glm::vec3* viewDir=nullptr,const glm::vec3* cameraPos=nullptr,const glm::vec3* lightDir=nullptr);
-    
-    //ݣȾ͸Ⱦ͸
-    void render(Shader &shader,const glm::vec3* viewDir=nullptr,const glm::vec3* cameraPos=nullptr,const glm::vec3* lightDir=nullptr);
-
-    void renderDepth(Shader& depthShader);//ӰͼȾ
-
-    //ռ͸棨 World ȫ򣩡
-    //ÿ tuple Ϊ (depth,texIndex,faceIndex,chunkPtr)depth  viewDir  cameraPos 
-    void collectTransparentFaces(std::vector<std::tuple<float,int,int,Chunk*>> &out,const glm::vec3* viewDir,const glm::vec3* cameraPos) const;
-
-    // VBO ɵĵ͸棺 texIndex faceIndex0..faceCount-1
-    void drawTransparentFace(int texIndex,int faceIndex) const;
-
-    //ȡ chunk ׶޳
-    int getChunkX() const { return chunkX;}
-    int getChunkZ() const { return chunkZ;}
-
-    ///־
-    bool needsMeshUpdate() const { return needsUpdate;}
-    void setNeedsMeshUpdate(bool v) { needsUpdate=v;}
-    bool isPendingBuild() const { return pendingBuild;}
-    void setPendingBuild(bool v) { pendingBuild=v;}
-
-private:
-    BlockType blocks[CHUNK_SIZE][CHUNK_HEIGHT][CHUNK_SIZE];
-    int chunkX,chunkZ;
-    std::vector<float> verticesByType[NUM_BLOCK_TEXTURES];
-    unsigned int VAOs[NUM_BLOCK_TEXTURES];
-    unsigned int VBOs[NUM_BLOCK_TEXTURES];
-    bool needsUpdate;
-    bool isFullMesh; //true=6false=Ż
-    bool pendingBuild;//ǷѼ빹
-    bool gpuLoaded;//Ƿ GPU ϴ VAO/VBO
-
-    //Greedy Meshing 
-    void addQuad(float x,float y,float z,int width,int height,int face,BlockType type);
-    void buildGreedyMesh(const glm::vec3* viewDir,const glm::vec3* lightDir);
-    bool isFaceVisible(int x,int y,int z,int face,BlockType blockType) const;
-    void ensureGpuLoaded();// GL ̴߳ VAO/VBO
-    void addFace(float x,float y,float z,int face,BlockType type);
-    glm::vec3 getBlockColor(BlockType type);
-};
+#pragma once
+#include "Common.h"
+#include "BlockStorage.h"
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+
+//稠密体数据：按 (y,z,x) 顺序存放 CHUNK_SIZE x [baseY,topY) x CHUNK_SIZE 的格子（与区段内索引顺序一致，整段可直接解包）
+//生成地形和构建网格时只覆盖有内容的高度范围，范围外按调用方给定的值处理
+//PAD>0 时 x/z 两侧各多出 PAD 格（坐标范围 [-PAD,CHUNK_SIZE+PAD)），用于存放邻居 chunk 的边界
+template<typename T,int PAD=0>
+class DenseVolume {
+public:
+    static constexpr int WIDTH=CHUNK_SIZE+2*PAD;
+
+    DenseVolume() : baseY(0),topY(0) {}
+
+    void resize(int base,int top,T fillValue) {
+        baseY=base;
+        topY=top>base ? top : base;
+        baseOffset=baseY*WIDTH*WIDTH;
+        data.assign((size_t)(topY-baseY)*WIDTH*WIDTH,fillValue);
+    }
+    //保持范围不变，全部重置为 value
+    void fill(T value) { std::fill(data.begin(),data.end(),value);}
+    int getBaseY() const { return baseY;}
+    int getTopY() const { return topY;}
+    bool containsY(int y) const { return y>=baseY && y<topY;}
+
+    //y 必须在 [baseY,topY) 内
+    T& at(int x,int y,int z) { return data[index(x,y,z)];}
+    const T& at(int x,int y,int z) const { return data[index(x,y,z)];}
+    //越界安全读取
+    T get(int x,int y,int z,T outside) const { return containsY(y) ? data[index(x,y,z)] : outside;}
+    //以 y 层为起点的连续存储（PAD==0 时一个区段占 VOLUME 个元素）
+    T* layer(int y) { return &data[index(0,y,0)];}
+    const T* layer(int y) const { return &data[index(0,y,0)];}
+
+private:
+    int index(int x,int y,int z) const { return (y*WIDTH+z+PAD)*WIDTH+x+PAD-baseOffset;}
+
+    int baseY,topY;
+    int baseOffset=0;//baseY 层在全高索引中的偏移
+    std::vector<T> data;
+};
+
+typedef DenseVolume<BlockType> DenseBlocks;
+typedef DenseVolume<BlockType,1> PaddedBlocks;
+
+//列掩码位：一个 64 位字表示某列连续 64 格的属性（第 i 位对应 baseY+i）
+typedef uint64_t ColumnMask;
+
+//区段内的列掩码：每列 16 位，第 y 位对应区段内第 y 层
+struct SectionColumnMasks {
+    uint16_t solid[CHUNK_SIZE*CHUNK_SIZE];
+    uint16_t opaque[CHUNK_SIZE*CHUNK_SIZE];
+    uint16_t fluid[CHUNK_SIZE*CHUNK_SIZE];
+};
+
+//垂直区段：16 格高的方块存储，记录非空气方块数以便快速判断“空”与“全为同一种方块”
+//只有混合区段分配列掩码，均匀区段（含空区段）的掩码由其方块类型直接推出
+struct ChunkSection {
+    PalettedContainer blocks;
+    int nonAirCount=0;
+    std::unique_ptr<SectionColumnMasks> masks;
+
+    bool isEmpty() const { return nonAirCount==0;}
+    bool isUniform() const { return isEmpty() || blocks.isUniform();}
+    BlockType uniformType() const { return isEmpty() ? AIR : blocks.uniformType();}
+
+    uint16_t solidBits(int x,int z) const { return masks ? masks->solid[z*CHUNK_SIZE+x] : (isSolidBlock(uniformType()) ? 0xFFFF : 0);}
+    uint16_t opaqueBits(int x,int z) const { return masks ? masks->opaque[z*CHUNK_SIZE+x] : (isOpaqueBlock(uniformType()) ? 0xFFFF : 0);}
+    uint16_t fluidBits(int x,int z) const { return masks ? masks->fluid[z*CHUNK_SIZE+x] : (isFluidBlock(uniformType()) ? 0xFFFF : 0);}
+    size_t memoryBytes() const { return blocks.memoryBytes()+(masks ? sizeof(SectionColumnMasks) : 0);}
+};
+
+//网格构建时使用的区段快照标志
+struct SectionFlags {
+    bool empty;
+    bool uniform;
+    BlockType type;//uniform 时有效
+};
+
+//网格构建的输入快照：chunk 方块的稠密拷贝，四周各带一格邻居边界（(CHUNK_SIZE+2) x [baseY,topY) x (CHUNK_SIZE+2)）
+//网格构建只读快照，不访问 World、不加锁。邻居未加载或地形未生成的一侧以 WATER 填充：
+//水面不向该侧发射面，其他方块照常发射（邻居生成后由 World 重建）
+struct MeshSnapshot {
+    int chunkX=0,chunkZ=0;
+    PaddedBlocks blocks;
+    std::vector<SectionFlags> sectionFlags;
+    int meshTop=0;//全部列中最高非空气方块的 y+1，更高的层不可能产生面
+    uint8_t missingSides=0;//第 i 位：面方向 i（0=+Z,1=-Z,2=-X,3=+X）一侧的邻居边界未拷入
+    uint32_t editVersion=0;//拷贝时 chunk 的编辑版本（见 Chunk::getEditVersion）
+};
+
+//水平四个面方向（0=+Z,1=-Z,2=-X,3=+X）对应的邻居 chunk 偏移，反方向为 side^1
+constexpr int SIDE_DX[4]={ 0,0,-1,1 };
+constexpr int SIDE_DZ[4]={ 1,-1,0,0 };
+
+//最高置位的位序号，v==0 时返回 -1
+inline int highestSetBit(ColumnMask v) {
+    if(v==0) return -1;
+    int n=0;
+    if(v>>32) { v>>=32;n+=32;}
+    if(v>>16) { v>>=16;n+=16;}
+    if(v>>8) { v>>=8;n+=8;}
+    if(v>>4) { v>>=4;n+=4;}
+    if(v>>2) { v>>=2;n+=2;}
+    if(v>>1) n+=1;
+    return n;
+}
+
+//[i0,i1] 闭区间对应的位掩码（自动裁剪到 0..63）
+inline ColumnMask columnRangeMask(int i0,int i1) {
+    if(i0<0) i0=0;
+    if(i1>63) i1=63;
+    if(i0>i1) return 0;
+    ColumnMask hi=(i1==63) ? ~ColumnMask(0) : ((ColumnMask(1)<<(i1+1))-1);
+    return hi & ~((ColumnMask(1)<<i0)-1);
+}
+
+//chunk 生命周期状态：主线程与工作线程按顺序推进，可在任意线程读取
+enum ChunkState : uint8_t {
+    CHUNK_QUEUED,     //已创建，地形生成任务在队列中
+    CHUNK_GENERATING, //工作线程正在生成地形
+    CHUNK_GENERATED,  //地形已生成
+    CHUNK_MESHING,    //工作线程正在构建网格
+    CHUNK_MESH_READY, //网格数据在上传队列中
+    CHUNK_UPLOADED,   //网格已上传到 GPU
+    CHUNK_EVICTING    //正在驱逐，即将归还对象池
+};
+constexpr int CHUNK_STATE_COUNT=CHUNK_EVICTING+1;
+
+//打包的 chunk 顶点（8 字节），由主着色器与阴影着色器解码：
+//position：局部 x（7 位）| 局部 z（7 位）| y（11 位）| 面方向（3 位，0=+Z,1=-Z,2=-X,3=+X,4=+Y,5=-Y）
+//attributes：u（7 位）| v（11 位）| 纹理组（8 位）| 世界坐标 UV 标记（1 位，水顶面按世界坐标平铺）
+//u/v 是四边形角点在面内的方块数（0..宽/高），纹理按 GL_REPEAT 平铺；法线由面方向查表，chunk 原点作为 uniform 传入
+//每个四边形 4 个顶点，按所有 chunk 共用的静态索引缓冲 (0,1,2,2,3,0) 画成两个三角形
+struct PackedVertex {
+    uint32_t position;
+    uint32_t attributes;
+};
+constexpr int QUAD_VERTICES=4;
+constexpr int QUAD_INDICES=6;
+constexpr int PACKED_XZ_BITS=7;
+constexpr int PACKED_Y_BITS=11;
+static_assert(CHUNK_SIZE<(1<<PACKED_XZ_BITS) && MAX_WORLD_HEIGHT<(1<<PACKED_Y_BITS),"打包顶点的坐标位宽不足");
+static_assert(NUM_BLOCK_TEXTURES<=256,"打包顶点的纹理组只有 8 位");
+
+inline PackedVertex packVertex(const glm::ivec3 &p,int face,int u,int v,int texIndex,bool worldUV) {
+    PackedVertex out;
+    out.position=uint32_t(p.x) | uint32_t(p.z)<<7 | uint32_t(p.y)<<14 | uint32_t(face)<<25;
+    out.attributes=uint32_t(u) | uint32_t(v)<<7 | uint32_t(texIndex)<<18 | (worldUV ? 1u<<26 : 0u);
+    return out;
+}
+//chunk 局部坐标
+inline glm::ivec3 unpackPosition(const PackedVertex &v) {
+    return glm::ivec3(v.position & 127u,(v.position>>14) & 2047u,(v.position>>7) & 127u);
+}
+inline bool operator==(const PackedVertex &a,const PackedVertex &b) { return a.position==b.position && a.attributes==b.attributes;}
+inline bool operator!=(const PackedVertex &a,const PackedVertex &b) { return !(a==b);}
+
+//透明面的打包质心：四个角点的 chunk 局部坐标之和的一半（即质心的两倍，必为整数）
+//x2（8 位）| z2（8 位）| y2（12 位）；上传后透明面的全局排序只需要质心，不再保留顶点
+static_assert(2*CHUNK_SIZE<(1<<8) && 2*MAX_WORLD_HEIGHT<(1<<12),"打包质心的坐标位宽不足");
+inline uint32_t packCentroid(const PackedVertex* quad) {
+    int x=0,y=0,z=0;
+    for(int v=0;v<QUAD_VERTICES;++v) {
+        glm::ivec3 p=unpackPosition(quad[v]);
+        x+=p.x;y+=p.y;z+=p.z;
+    }
+    return uint32_t(x/2) | uint32_t(z/2)<<8 | uint32_t(y/2)<<16;
+}
+//chunk 局部坐标
+inline glm::vec3 unpackCentroid(uint32_t c) {
+    return glm::vec3(float(c & 255u),float(c>>16),float((c>>8) & 255u))*0.5f;
+}
+
+//每个纹理组内的四边形按面方向 0..5 连续排列：方向 f 占 [faceOffsets[t][f],faceOffsets[t][f+1]) 个四边形
+//渲染时按相机所在一侧只绘制可能朝向相机的方向，无需为视角重建网格
+typedef uint32_t FaceOffsets[6+1];
+
+struct MeshData {
+    int chunkX;
+    int chunkZ;
+    std::vector<PackedVertex> verticesByType[NUM_BLOCK_TEXTURES];
+    FaceOffsets faceOffsets[NUM_BLOCK_TEXTURES]={};
+    int meshBottom=0,meshTop=0;//所有面所在的高度范围 [meshBottom,meshTop]
+    std::vector<uint32_t> transparentCentroids[NUM_BLOCK_TEXTURES];//透明纹理组每个四边形的打包质心（packCentroid），其他组为空
+    uint8_t missingSides=0;//构建时缺失邻居边界的方向（同 MeshSnapshot::missingSides）
+    uint32_t editVersion=0;//构建所用快照的编辑版本
+};
+
+class Chunk {
+public:
+    Chunk(int x,int z);
+    ~Chunk();
+
+    //由 ChunkPool 复用：清空方块与网格并移到新坐标，保留 VAO/VBO 名字与显存
+    void reset(int x,int z);
+
+    void generateTerrain() { generateTerrain(getJobEpoch());}
+    //工作线程用：各生成阶段之间检查 epoch，任务已被取消时放弃并返回 false（不写入方块存储）
+    bool generateTerrain(uint32_t epoch);
+    BlockType getBlock(int x,int y,int z) const; 
+    //主线程读取（不加锁）：地形生成完成后只有主线程写入方块存储，主线程读不会与写并发；工作线程的读本身互不冲突
+    //地形尚未生成完的 chunk 仍走加锁的 getBlock。BlockCursor 等主线程逐方块访问用它
+    BlockType getBlockOnMainThread(int x,int y,int z) const;
+    void setBlock(int x,int y,int z,BlockType type);
+    //编辑版本：每次 setBlock 或 markEdited 加一（在 storageMutex 内，与方块写入原子），快照记下拷贝时的版本
+    //网格的版本落后于 chunk 说明构建开始后又被编辑过。只有主线程修改，主线程可直接读
+    uint32_t getEditVersion() const { return editVersion;}
+    //邻居的边界方块被编辑：本 chunk 的方块不变，但共享面要重建（须在邻居写入之后调用）
+    void markEdited();
+
+    //读取局部坐标闭区间 [x0,x1]x[y0,y1]x[z0,z1]（须在 chunk 与世界高度范围内）到 out，只加锁一次
+    //(x,y,z) 写入 out[(y-y0)*strideY+(z-z0)*strideZ+(x-x0)]
+    void readRegion(int x0,int x1,int y0,int y1,int z0,int z1,BlockType* out,int strideY,int strideZ) const;
+
+    //网格快照：将压缩存储整体解包到 out（网格构建前调用一次，避免逐方块解码），四周边界先按缺失填充
+    void copyForMeshing(MeshSnapshot &out) const;
+    //本 chunk 位于 out 所属 chunk 的 side 方向：把朝向它的一层边界拷入 out 的对应边界（只加锁一次）
+    void copyBorderTo(MeshSnapshot &out,int side) const;
+
+    //区段查询：空区段（全空气）与均匀区段（全为同一种方块）
+    bool isSectionEmpty(int section) const;
+    bool isSectionUniform(int section,BlockType* type=nullptr) const;
+
+    //列查询（生成地形和每次 setBlock 时增量维护）
+    //最高实心方块的 y，整列无实心方块（含尚未生成地形）时返回 -1（常数时间）
+    int getTopSolidY(int x,int z) const;
+    //从 baseY 开始连续 64 格的列掩码，第 i 位对应 baseY+i，世界高度范围外为 0
+    ColumnMask getSolidMask(int x,int z,int baseY=0) const;
+    ColumnMask getOpaqueMask(int x,int z,int baseY=0) const;
+    ColumnMask getFluidMask(int x,int z,int baseY=0) const;
+
+    //有内容（非空区段）的高度范围 [bottom,top)，整块为空时两者均为 0
+    void getContentRange(int &bottom,int &top) const;
+
+    //列高度图与混合区段列掩码占用的字节数
+    size_t columnMemoryBytes() const;
+
+    //方块数据当前占用的字节数（各区段调色板+压缩数据）
+    size_t blockMemoryBytes() const;
+    //指定区段的每方块位宽（0/1/2/4/8），用于内存统计
+    int sectionBitsPerEntry(int section) const;
+
+    //仅 CPU 的网格生成，只读快照，返回网格数据（可在工作线程中调用）；按行位掩码剔除与合并
+    //构建在线程局部的临时缓冲中进行（容量跨构建保留），返回的各顶点数组按实际大小只分配一次
+    static MeshData buildMeshCPU(const MeshSnapshot &snapshot);
+    //逐方块判断可见性的参考实现，输出与 buildMeshCPU 相同（用于等价性检查与基准对比）
+    static MeshData buildMeshCPUScalar(const MeshSnapshot &snapshot);
+
+    //将网格数据上传到 GPU（必须在主线程/OpenGL 上下文中调用）；顶点不在 chunk 中保留，
+    //只移入各方向的四边形数与透明面质心，data 中的顶点数组随调用方释放
+    void uploadMeshFromData(MeshData&& data);
+    //网格在 CPU 常驻的字节数（方向范围与透明面质心）与已上传到 GPU 的顶点字节数
+    size_t meshResidentBytes() const;
+    size_t meshVertexBytes() const;
+
+    //仅渲染不透明几何（写入深度）；给出 cameraPos 时跳过整块 chunk 都背向相机的面方向，返回提交的四边形数
+    size_t renderOpaque(Shader &shader,const glm::vec3* cameraPos=nullptr);
+    //不透明几何的四边形总数（不做方向剔除时 renderOpaque 提交的数量）
+    size_t opaqueQuadCount() const;
+    //相机位于 cameraPos 时可能朝向相机的面方向（第 f 位对应面方向 f）：按 chunk 包围盒判断，相机在某方向所有面平面的背面时该方向整体不可见
+    uint8_t visibleFaceMask(const glm::vec3 &cameraPos) const;
+
+    //仅渲染透明几何（必须在所有不透明几何绘制后调用）
+    //'viewDir' 和 'cameraPos' 用于对透明面进行从远到近排序
+    void renderTransparent(Shader &shader,const glm::vec3* viewDir=nullptr,const glm::vec3* cameraPos=nullptr,const glm::vec3* lightDir=nullptr);
+    
+    //便捷：先渲染不透明再渲染透明
+    void render(Shader &shader,const glm::vec3* viewDir=nullptr,const glm::vec3* cameraPos=nullptr,const glm::vec3* lightDir=nullptr);
+
+    //阴影贴图渲染；给出 towardLight（指向光源的方向光方向）时只绘制朝向光源的面方向
+    void renderDepth(Shader& depthShader,const glm::vec3* towardLight=nullptr);
+
+    //收集透明面（供 World 进行全局排序）。
+    //每个 tuple 为 (depth,texIndex,faceIndex,chunkPtr)。depth 沿 viewDir 相对于 cameraPos 计算
+    void collectTransparentFaces(std::vector<std::tuple<float,int,int,Chunk*>> &out,const glm::vec3* viewDir,const glm::vec3* cameraPos) const;
+
+    //绘制在 VBO 中生成的单个透明面：纹理组 texIndex，面索引 faceIndex（0..faceCount-1）
+    void drawTransparentFace(Shader &shader,int texIndex,int faceIndex) const;
+
+    //获取 chunk 坐标用于视锥剔除
+    int getChunkX() const { return chunkX;}
+    int getChunkZ() const { return chunkZ;}
+
+    //网格更新/挂起标志访问器
+    bool needsMeshUpdate() const { return needsUpdate;}
+    void setNeedsMeshUpdate(bool v) { needsUpdate=v;}
+    bool isPendingBuild() const { return pendingBuild;}
+    void setPendingBuild(bool v) { pendingBuild=v;}
+    //在途任务被取消、等回到视距内再重新提交（主线程；此时 pendingBuild 保持为 true）
+    bool isJobDeferred() const { return jobDeferred;}
+    void setJobDeferred(bool v) { jobDeferred=v;}
+    //当前网格构建时缺失邻居边界的方向（主线程）
+    uint8_t getMeshMissingSides() const { return meshMissingSides;}
+    //自创建（或从对象池取出）以来是否已上传过网格（主线程）
+    bool hasMesh() const { return meshUploaded;}
+    //最早一次尚未显示的编辑的时间（主线程，用于统计编辑到可见的延迟）
+    bool hasUnseenEdit() const { return unseenEdit;}
+    std::chrono::steady_clock::time_point getUnseenEditTime() const { return unseenEditTime;}
+    void setUnseenEdit(bool v,std::chrono::steady_clock::time_point t=std::chrono::steady_clock::time_point()) { unseenEdit=v;unseenEditTime=t;}
+
+    //生命周期状态与在途任务引用计数（由 ChunkHandle 维护）
+    ChunkState getState() const { return static_cast<ChunkState>(state.load(std::memory_order_acquire));}
+    //地形已生成（可作为邻居拷贝边界）
+    bool hasTerrain() const { ChunkState s=getState();return s!=CHUNK_QUEUED && s!=CHUNK_GENERATING;}
+    void setState(ChunkState s) { state.store(s,std::memory_order_release);}
+    int getRefCount() const { return refCount.load(std::memory_order_acquire);}
+    void addRef() { refCount.fetch_add(1,std::memory_order_relaxed);}
+    void releaseRef() { refCount.fetch_sub(1,std::memory_order_acq_rel);}
+    //任务纪元：任务提交时记下，主线程 cancelJobs 使其前进，持旧纪元的任务在检查点放弃（对象池复用时不归零）
+    uint32_t getJobEpoch() const { return jobEpoch.load(std::memory_order_acquire);}
+    void cancelJobs() { jobEpoch.fetch_add(1,std::memory_order_acq_rel);}
+    bool isJobCancelled(uint32_t epoch) const { return jobEpoch.load(std::memory_order_acquire)!=epoch;}
+
+private:
+    //按 16 格高度划分的调色板压缩存储（共 getWorldSections() 段），由 storageMutex 保护（工作线程读、主线程写）
+    std::vector<ChunkSection> sections;
+    mutable std::mutex storageMutex;
+    //列高度图（同样由 storageMutex 保护）：最高非空气方块与最高实心方块的 y+1（无则为 0）
+    uint16_t columnTop[CHUNK_SIZE][CHUNK_SIZE]={};
+    uint16_t solidTop[CHUNK_SIZE][CHUNK_SIZE]={};
+    int chunkX,chunkZ;
+    //上传后只保留绘制所需的元数据：各纹理组内面方向的四边形范围（见 MeshData::faceOffsets，末项即四边形总数）与透明面质心
+    FaceOffsets faceOffsets[NUM_BLOCK_TEXTURES]={};
+    int meshBottom=0,meshTop=0;
+    std::vector<uint32_t> transparentCentroids[NUM_BLOCK_TEXTURES];
+    unsigned int VAOs[NUM_BLOCK_TEXTURES];
+    unsigned int VBOs[NUM_BLOCK_TEXTURES];
+    bool needsUpdate;
+    bool pendingBuild;//是否已加入构建队列
+    bool gpuLoaded;//是否已在 GPU 上创建 VAO/VBO
+    uint8_t meshMissingSides=0;
+    bool meshUploaded=false;
+    bool jobDeferred=false;
+    uint32_t editVersion=0;//由 storageMutex 保护写入
+    bool unseenEdit=false;
+    std::chrono::steady_clock::time_point unseenEditTime;
+    std::atomic<uint8_t> state{CHUNK_QUEUED};
+    std::atomic<int> refCount{0};//在途任务持有的引用数，为 0 时才可驱逐
+    std::atomic<uint32_t> jobEpoch{0};
+    size_t gpuCapacity[NUM_BLOCK_TEXTURES]={};//各 VBO 当前已分配的显存字节数，容量足够时只做子数据更新
+
+    //邻居取自快照（含一格边界），不跨 chunk 查找
+    static bool isFaceVisible(const PaddedBlocks &blocks,int x,int y,int z,int face,BlockType blockType);
+    //将稠密数组中 [lowY,highY) 的部分打包进各区段；低于 lowY 的区段整段填充 STONE，不低于 highY 的整段填充 AIR
+    //打包时同时重建列掩码与高度图
+    void storeBlocks(const DenseBlocks &src,int lowY,int highY);
+    //单个方块由 old 变为 type 后更新所在区段的列掩码与列高度图（调用方须持有 storageMutex，且已写入方块）
+    void updateColumn(int x,int y,int z,BlockType old,BlockType type);
+    //按区段列掩码取 baseY 起 64 格（调用方须持有 storageMutex）；kind：0=实心，1=不透明，2=流体
+    ColumnMask columnBits(int x,int z,int baseY,int kind) const;
+    void ensureGpuLoaded();//在 GL 线程创建 VAO/VBO
+    void uploadVertexBuffers(const MeshData &data);//将 data 的各纹理组顶点上传到对应 VBO（GL 线程）
+    //从 data 取得面方向范围、高度范围与透明面质心
+    void takeMeshLayout(MeshData &data);
+    uint32_t quadCount(int texIndex) const { return faceOffsets[texIndex][6];}
+    //绘制纹理组 texIndex 中 faceMask 选中的面方向，相邻方向合并为一次绘制，返回四边形数
+    size_t drawFaceRanges(int texIndex,uint8_t faceMask) const;
+    //打包顶点的局部坐标相对的世界坐标原点（着色器 uniform chunkOrigin）
+    glm::vec3 meshOrigin() const { return glm::vec3(chunkX*CHUNK_SIZE,0,chunkZ*CHUNK_SIZE);}
+    glm::vec3 getBlockColor(BlockType type);
+};
+
+//在途任务对 chunk 的引用：队列中的地形/构建/上传条目各持有一个，析构时释放
+//只有主线程会从零开始创建引用（入队时），因此主线程看到计数为 0 即可安全驱逐
+class ChunkHandle {
+public:
+    ChunkHandle() : chunk(nullptr) {}
+    explicit ChunkHandle(Chunk* c) : chunk(c) { if(chunk) chunk->addRef();}
+    ChunkHandle(const ChunkHandle& other) : chunk(other.chunk) { if(chunk) chunk->addRef();}
+    ChunkHandle(ChunkHandle&& other) noexcept : chunk(other.chunk) { other.chunk=nullptr;}
+    ChunkHandle& operator=(ChunkHandle other) { std::swap(chunk,other.chunk);return *this;}
+    ~ChunkHandle() { if(chunk) chunk->releaseRef();}
+
+    Chunk* get() const { return chunk;}
+    Chunk* operator->() const { return chunk;}
+    explicit operator bool() const { return chunk!=nullptr;}
+
+private:
+    Chunk* chunk;
+};
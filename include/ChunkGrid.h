@@ -0,0 +1,72 @@
+#pragma once
+#include "Common.h"
+#include "Chunk.h"
+
+#include <vector>
+#include <map>
+#include <climits>
+#include <atomic>
+#include <memory>
+
+//==================== 环形 chunk 网格 ====================
+//按 chunk 坐标对网格边长取模定位槽位（边长为 2 的幂，取模即按位与），查找为 O(1)
+//边长覆盖整个驱逐范围，因此驱逐半径内的 chunk 永远不会争用同一槽位；
+//范围外的 chunk（远处的 getBlock 等）遇到槽位冲突时放入溢出表，recenter 时迁回空闲槽位
+//另维护紧凑的存活列表用于遍历（删除时与末尾交换，遍历顺序不稳定）
+//写入与 find/遍历只在主线程进行；另为每个槽位维护一份原子发布指针供工作线程无锁查找（findConcurrent）
+class ChunkGrid {
+public:
+    //minWidth：需要无冲突覆盖的边长（chunk 数），实际边长取不小于它的 2 的幂
+    explicit ChunkGrid(int minWidth);
+
+    Chunk* find(int chunkX,int chunkZ) const {
+        const Slot &s=slots[slotIndex(chunkX,chunkZ)];
+        if(s.x==chunkX && s.z==chunkZ) return s.chunk;
+        return overflow.empty() ? nullptr : findOverflow(chunkX,chunkZ);
+    }
+    bool contains(int chunkX,int chunkZ) const { return find(chunkX,chunkZ)!=nullptr;}
+
+    //任意线程可调用的无锁查找：只看槽位的发布指针，溢出表中的 chunk 视为未加载
+    //返回的 chunk 只在调用方处于 World 的纪元读临界区内时有效（驱逐的 chunk 延迟到读者退出后才回收）
+    Chunk* findConcurrent(int chunkX,int chunkZ) const {
+        Chunk* c=published[slotIndex(chunkX,chunkZ)].load();
+        return (c && c->getChunkX()==chunkX && c->getChunkZ()==chunkZ) ? c : nullptr;
+    }
+
+    //插入 chunk（坐标取自 chunk 本身），调用方保证该坐标尚无 chunk
+    void insert(Chunk* chunk);
+    //移除并返回指定坐标的 chunk，不存在时返回 nullptr（不释放 chunk）
+    Chunk* erase(int chunkX,int chunkZ);
+    //玩家所在 chunk 变化时调用：窗口内的溢出 chunk 迁回网格（槽位被窗口外 chunk 占用时与之交换）
+    void recenter(int chunkX,int chunkZ);
+
+    //紧凑的存活列表（遍历期间不要插入/删除）
+    const std::vector<Chunk*>& all() const { return live;}
+    std::vector<Chunk*>::const_iterator begin() const { return live.begin();}
+    std::vector<Chunk*>::const_iterator end() const { return live.end();}
+    size_t size() const { return live.size();}
+    bool empty() const { return live.empty();}
+
+    int width() const { return 1<<shift;}
+    size_t overflowCount() const { return overflow.size();}
+
+private:
+    struct Slot {
+        int x=INT_MIN,z=INT_MIN;//空槽位使用不可能出现的坐标，查找只需比较坐标
+        Chunk* chunk=nullptr;
+        int liveIndex=-1;//在 live 中的下标
+    };
+
+    int slotIndex(int chunkX,int chunkZ) const { return ((chunkZ&mask)<<shift)|(chunkX&mask);}
+    Chunk* findOverflow(int chunkX,int chunkZ) const;
+    Slot* findSlot(int chunkX,int chunkZ);
+    //槽位内容变化后同步发布指针
+    void publish(const Slot &s) { published[&s-slots.data()].store(s.chunk);}
+
+    int shift;
+    int mask;
+    std::vector<Slot> slots;
+    std::unique_ptr<std::atomic<Chunk*>[]> published;//与 slots 一一对应
+    std::map<std::pair<int,int>,Slot> overflow;
+    std::vector<Chunk*> live;
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include "Common.h"
+#include "Chunk.h"
+
+#include <vector>
+
+//==================== Chunk 对象池 ====================
+//被驱逐的 chunk 不立即 delete，而是放回空闲链表：
+//  复用 Chunk 对象本身的内存、CPU 顶点缓冲的容量以及已创建的 VAO/VBO 名字和显存
+//空闲数量超过高水位时才真正释放（必须在主 GL 线程调用 release/trim/析构）
+class ChunkPool {
+public:
+    static constexpr size_t DEFAULT_HIGH_WATER_MARK=128;
+
+    ChunkPool();
+    ~ChunkPool();
+
+    //取出一个 chunk 并重置到指定坐标；空闲链表为空时新建
+    Chunk* acquire(int chunkX,int chunkZ);
+    //归还 chunk；空闲数量已达高水位时直接释放
+    void release(Chunk* chunk);
+
+    //高水位：空闲链表最多保留的 chunk 数量（降低时立即释放多余部分）
+    void setHighWaterMark(size_t n);
+    size_t getHighWaterMark() const { return highWaterMark;}
+
+    size_t freeCount() const { return freeList.size();}
+    size_t hitCount() const { return hits;}//acquire 命中空闲链表
+    size_t missCount() const { return misses;}//acquire 新建
+    size_t discardCount() const { return discards;}//超过高水位被释放
+
+    void printStats() const;
+
+private:
+    void trim();
+
+    std::vector<Chunk*> freeList;
+    size_t highWaterMark;
+    size_t hits=0;
+    size_t misses=0;
+    size_t discards=0;
+};
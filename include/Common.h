@@ -1,166 +1,219 @@
-#pragma once
-
-#include <iostream>
-#include <vector>
-#include <string>
-#include <cmath>
-#include <map>
-#include <fstream>
-
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
-
-#include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
-#include <glm/gtc/noise.hpp>
-
-#define HAS_SOIL 1
-#include <SOIL.h>
-
-//====================  ====================
-constexpr int WINDOW_WIDTH=1280;
-constexpr int WINDOW_HEIGHT=720;
-constexpr int CHUNK_SIZE=16;
-constexpr int CHUNK_HEIGHT=64;
-constexpr float BLOCK_SIZE=1.0f;
-constexpr float PLAYER_SPEED=5.0f;
-constexpr float MOUSE_SENSITIVITY=0.1f;
-constexpr float REACH_DISTANCE=5.0f;
-constexpr int TARGET_FPS=60;
-constexpr float TARGET_FRAME_TIME=1.0f/TARGET_FPS;
-
-constexpr float PLAYER_WIDTH=0.6f;
-constexpr float PLAYER_HEIGHT=1.8f;
-constexpr float PLAYER_EYE_HEIGHT=1.6f;
-constexpr float STEP_HEIGHT=1.0f;
-constexpr float STEP_DURATION=0.30f;
-constexpr float STEPPING_SPEED_MULT=0.6f;
-
-constexpr int WATER_LEVEL=22;
-constexpr int BASE_HEIGHT=30;
-constexpr float CONTINENT_SCALE=0.008f;
-constexpr float TERRAIN_SCALE=0.03f;
-constexpr float DETAIL_SCALE=0.12f;
-constexpr float MOUNTAIN_SCALE=0.015f;
-constexpr float EROSION_SCALE=0.05f;
-constexpr int MAX_TERRAIN_HEIGHT=60;
-constexpr int MIN_TERRAIN_HEIGHT=10;
-
-constexpr float RIVER_FREQ=0.015f;
-constexpr float RIVER_WIDTH=0.12f;
-constexpr int RIVER_DEPTH=10;
-
-//
-constexpr int NUM_BLOCK_TEXTURES=9;//GRASS_TOP,DIRT,STONE,WOOD,LEAVES,SAND,WATER,GRASS_SIDE,CLOUD
-extern GLuint blockTextures[NUM_BLOCK_TEXTURES];
-
-//ȫͼʱ
-extern GLuint panoramaTextures[6];
-
-//
-extern GLuint titleTexture;
-
-//
-extern GLuint subtitleTexture;
-
-//
-extern GLuint sphereTexture;
-
-//====================  ====================
-enum BlockType {
-    AIR=0,   //͸Ⱦ
-    GRASS,     //ݷ飨ɫ
-    DIRT,      //飨ɫ
-    STONE,     //ʯͷ飨ɫ
-    WOOD,      //ľͷ飨ɫ
-    LEAVES,    //Ҷ飨ɫ
-    SAND,      //ɳӷ飨ǳɫ
-    WATER,     //ˮ飨ɫ
-    CLOUD       //ƿ飨ף͸Ⱦϵƣ
-};
-
-// BlockType ӳ䵽 AIR ͣ
-int blockTypeToTexIndex(BlockType t);
-
-//ǰ Camera ʹ World ࣩ
-class World;
-
-//==================== ɸ ====================
-float octavePerlin(float x,float z,int octaves,float persistence,float lacunarity,float scale);
-float smoothLerp(float a,float b,float t);
-float calculateTerrainHeight(float worldX,float worldZ);
-
-//==================== Ⱥϵ ====================
-enum BiomeType {
-    BIOME_OCEAN,
-    BIOME_BEACH,
-    BIOME_PLAINS,
-    BIOME_FOREST,
-    BIOME_DESERT,
-    BIOME_MOUNTAINS,
-    BIOME_SNOW
-};
-
-BiomeType getBiome(float worldX,float worldZ,float height);
-
-//====================  ǰ ====================
-class Camera {
-public:
-    glm::vec3 position;
-    glm::vec3 front;
-    glm::vec3 up;
-    glm::vec3 right;
-    float yaw;
-    float pitch;
-
-    //̨״̬
-    bool isStepping=false;
-    float stepElapsed=0.0f;
-    float stepStartY=0.0f;
-    float stepTargetDeltaY=0.0f;
-    float stepPendX=0.0f;
-    float stepPendZ=0.0f;
-
-    Camera(glm::vec3 pos=glm::vec3(0.0f,32.0f,0.0f));
-    glm::mat4 getViewMatrix() const;//const
-    glm::vec3 getFootPosition() const;
-    bool checkCollision(const glm::vec3& pos,World& world) const;
-    void processKeyboard(int direction,float deltaTime,World& world);
-    void processMouseMovement(float xoffset,float yoffset);
-    //ƶģʽ
-    enum MovementMode { GRAVITY_MODE=0,FLY_MODE=1 };
-    MovementMode movementMode=GRAVITY_MODE;
-    void setMovementMode(MovementMode m) { movementMode=m;}
-    MovementMode getMovementMode() const { return movementMode;}
-    void toggleMovementMode() { 
-        movementMode=(movementMode==GRAVITY_MODE) ? FLY_MODE : GRAVITY_MODE;
-    }
-
-    //ÿ֡£ģʽӦ/
-    void updatePhysics(float deltaTime,World& world);
-private:
-    void updateCameraVectors();
-    //ֱٶȣģʽ
-    float verticalVelocity=0.0f;
-    //ٶ
-    float gravityAcc=-9.8f;
-    //ڽûʱǿϵ
-    float buoyancyFactor=0.9f;
-};
-
-//ǰ Shader
-class Shader;
-
-//==================== Chunk/World ǰ ====================
-class Chunk;
-class World;
-
-//
-void loadBlockTextures();
-void loadPanoramaTextures();
-
-
-
-
-
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <map>
+#include <fstream>
+#include <cstdint>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/noise.hpp>
+
+#define HAS_SOIL 1
+#include <SOIL.h>
+
+//==================== 常量定义 ====================
+constexpr int WINDOW_WIDTH=1280;
+constexpr int WINDOW_HEIGHT=720;
+//chunk 水平边长在编译期选择（/D YC_CHUNK_SIZE=32 等），必须是 16..64 之间的 2 的幂
+#ifndef YC_CHUNK_SIZE
+#define YC_CHUNK_SIZE 16
+#endif
+constexpr int CHUNK_SIZE=YC_CHUNK_SIZE;
+constexpr int SECTION_SIZE=16;//方块存储区段高度（CHUNK_SIZE x 16 x CHUNK_SIZE）
+constexpr int DEFAULT_WORLD_HEIGHT=64;
+constexpr int MAX_WORLD_HEIGHT=1024;
+constexpr float BLOCK_SIZE=1.0f;
+constexpr float PLAYER_SPEED=5.0f;
+constexpr float MOUSE_SENSITIVITY=0.1f;
+constexpr float REACH_DISTANCE=5.0f;
+constexpr int TARGET_FPS=60;
+constexpr float TARGET_FRAME_TIME=1.0f/TARGET_FPS;
+
+constexpr float PLAYER_WIDTH=0.6f;
+constexpr float PLAYER_HEIGHT=1.8f;
+constexpr float PLAYER_EYE_HEIGHT=1.6f;
+constexpr float STEP_HEIGHT=1.0f;
+constexpr float STEP_DURATION=0.30f;
+constexpr float STEPPING_SPEED_MULT=0.6f;
+
+constexpr int WATER_LEVEL=22;
+constexpr int BASE_HEIGHT=30;
+constexpr float CONTINENT_SCALE=0.008f;
+constexpr float TERRAIN_SCALE=0.03f;
+constexpr float DETAIL_SCALE=0.12f;
+constexpr float MOUNTAIN_SCALE=0.015f;
+constexpr float EROSION_SCALE=0.05f;
+constexpr int MAX_TERRAIN_HEIGHT=60;
+constexpr int MIN_TERRAIN_HEIGHT=10;
+
+//视距与驱逐距离按方块计，换算成 chunk 数后不同 chunk 尺寸覆盖同样的范围
+constexpr int RENDER_DISTANCE_BLOCKS=160;
+constexpr int EVICTION_MARGIN_BLOCKS=80;
+
+constexpr float RIVER_FREQ=0.015f;
+constexpr float RIVER_WIDTH=0.12f;
+constexpr int RIVER_DEPTH=10;
+
+//纹理
+constexpr int NUM_BLOCK_TEXTURES=9;//GRASS_TOP,DIRT,STONE,WOOD,LEAVES,SAND,WATER,GRASS_SIDE,CLOUD
+extern GLuint blockTextures[NUM_BLOCK_TEXTURES];
+
+//全景贴图（启动时）
+extern GLuint panoramaTextures[6];
+
+//标题纹理
+extern GLuint titleTexture;
+
+//副标题纹理
+extern GLuint subtitleTexture;
+
+//球体纹理（足球）
+extern GLuint sphereTexture;
+
+//==================== 方块类型 ====================
+enum BlockType : uint8_t {//按字节存储，区块内方块数据以此为基线
+    AIR=0,   //空气（透明，不渲染）
+    GRASS,     //草方块（绿色）
+    DIRT,      //泥土方块（棕色）
+    STONE,     //石头方块（灰色）
+    WOOD,      //木头方块（褐色）
+    LEAVES,    //树叶方块（深绿色）
+    SAND,      //沙子方块（浅黄色）
+    WATER,     //水方块（蓝色）
+    CLOUD       //云块（纯白，部分透明，用于渲染天上的云）
+};
+
+//==================== chunk 尺寸与坐标换算 ====================
+constexpr int log2Exact(int v) { return v<=1 ? 0 : 1+log2Exact(v>>1);}
+constexpr bool isPowerOfTwo(int v) { return v>0 && (v&(v-1))==0;}
+
+//chunk 的编译期尺寸：SX x SY x SZ（SY 为一个存储区段的高度），坐标换算全部是移位和掩码
+//世界坐标 -> chunk 坐标用算术右移，负坐标同样向下取整
+template<int SX,int SY,int SZ>
+struct ChunkDims {
+    static_assert(isPowerOfTwo(SX) && isPowerOfTwo(SY) && isPowerOfTwo(SZ),"chunk 尺寸必须是 2 的幂");
+    static constexpr int SIZE_X=SX,SIZE_Y=SY,SIZE_Z=SZ;
+    static constexpr int SHIFT_X=log2Exact(SX),SHIFT_Y=log2Exact(SY),SHIFT_Z=log2Exact(SZ);
+    static constexpr int MASK_X=SX-1,MASK_Y=SY-1,MASK_Z=SZ-1;
+    static constexpr int AREA=SX*SZ;//一层的格子数
+    static constexpr int VOLUME=SX*SY*SZ;//一个区段的格子数
+
+    static constexpr int chunkOfX(int x) { return x>>SHIFT_X;}
+    static constexpr int chunkOfZ(int z) { return z>>SHIFT_Z;}
+    static constexpr int localX(int x) { return x&MASK_X;}
+    static constexpr int localZ(int z) { return z&MASK_Z;}
+    static constexpr int sectionOf(int y) { return y>>SHIFT_Y;}
+    static constexpr int localY(int y) { return y&MASK_Y;}
+    //区段内索引 (y,z,x)，同一行 x 连续
+    static constexpr int indexOf(int x,int y,int z) { return (y<<(SHIFT_X+SHIFT_Z))|(z<<SHIFT_X)|x;}
+};
+
+typedef ChunkDims<CHUNK_SIZE,SECTION_SIZE,CHUNK_SIZE> ChunkLayout;
+static_assert(CHUNK_SIZE>=16 && CHUNK_SIZE<=64,"YC_CHUNK_SIZE 只支持 16/32/64");
+
+//==================== 世界高度 ====================
+//世界高度在启动时选择（由若干 16 格高的区段堆叠而成），必须在创建任何 chunk 之前设置
+//传入值向上取整为 SECTION_SIZE 的倍数，并限制在 [DEFAULT_WORLD_HEIGHT,MAX_WORLD_HEIGHT]
+void setWorldHeight(int height);
+int getWorldHeight();
+int getWorldSections();//getWorldHeight()/SECTION_SIZE
+//云层高度：不随世界加高而上移，高处的空区段不产生存储和网格开销
+int getCloudLevel();
+
+//将 BlockType 映射到纹理索引（非 AIR 类型）
+int blockTypeToTexIndex(BlockType t);
+
+//方块属性：实心（参与玩家碰撞）、不透明（完全遮挡相邻面）、流体
+inline bool isSolidBlock(BlockType t) { return t!=AIR && t!=WATER && t!=LEAVES;}
+inline bool isOpaqueBlock(BlockType t) { return isSolidBlock(t) && t!=CLOUD;}
+inline bool isFluidBlock(BlockType t) { return t==WATER;}
+
+//前向声明（让 Camera 类可以使用 World 类）
+class World;
+
+//==================== 地形生成辅助函数 ====================
+float octavePerlin(float x,float z,int octaves,float persistence,float lacunarity,float scale);
+float smoothLerp(float a,float b,float t);
+float calculateTerrainHeight(float worldX,float worldZ);
+
+//==================== 生物群系 ====================
+enum BiomeType {
+    BIOME_OCEAN,
+    BIOME_BEACH,
+    BIOME_PLAINS,
+    BIOME_FOREST,
+    BIOME_DESERT,
+    BIOME_MOUNTAINS,
+    BIOME_SNOW
+};
+
+BiomeType getBiome(float worldX,float worldZ,float height);
+
+//==================== 摄像机类 前向声明 ====================
+class Camera {
+public:
+    glm::vec3 position;
+    glm::vec3 front;
+    glm::vec3 up;
+    glm::vec3 right;
+    float yaw;
+    float pitch;
+
+    //台阶状态
+    bool isStepping=false;
+    float stepElapsed=0.0f;
+    float stepStartY=0.0f;
+    float stepTargetDeltaY=0.0f;
+    float stepPendX=0.0f;
+    float stepPendZ=0.0f;
+
+    Camera(glm::vec3 pos=glm::vec3(0.0f,32.0f,0.0f));
+    glm::mat4 getViewMatrix() const;//添加const
+    glm::vec3 getFootPosition() const;
+    bool checkCollision(const glm::vec3& pos,World& world) const;
+    void processKeyboard(int direction,float deltaTime,World& world);
+    void processMouseMovement(float xoffset,float yoffset);
+    //移动模式
+    enum MovementMode { GRAVITY_MODE=0,FLY_MODE=1 };
+    MovementMode movementMode=GRAVITY_MODE;
+    void setMovementMode(MovementMode m) { movementMode=m;}
+    MovementMode getMovementMode() const { return movementMode;}
+    void toggleMovementMode() { 
+        movementMode=(movementMode==GRAVITY_MODE) ? FLY_MODE : GRAVITY_MODE;
+    }
+
+    //每帧物理更新（在重力模式下应用重力/浮力）
+    void updatePhysics(float deltaTime,World& world);
+private:
+    void updateCameraVectors();
+    //垂直速度（重力模式）
+    float verticalVelocity=0.0f;
+    //重力加速度
+    float gravityAcc=-9.8f;
+    //在浸没时浮力强度系数
+    float buoyancyFactor=0.9f;
+};
+
+//前向声明 Shader
+class Shader;
+
+//==================== Chunk/World 前向声明 ====================
+class Chunk;
+class World;
+
+//纹理加载器函数
+void loadBlockTextures();
+void loadPanoramaTextures();
+
+
+
+
+
@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+//==================== 基于纪元的延迟回收 ====================
+//读者进入临界区时登记当前全局纪元，退出时清零；写者先撤下对象的发布指针，再调用 retire()
+//得到退休纪元 e 并推进全局纪元。所有活跃读者的纪元都大于 e 之后（e<safeEpoch()），
+//不会再有读者持有该对象，此时才能真正回收
+//读路径只有两次原子写，不加锁；每个读者线程首次使用时分配一个槽位，线程结束时归还
+class EpochManager {
+public:
+    static constexpr int MAX_READERS=256;
+
+    EpochManager();
+
+    //读者临界区（RAII），可嵌套
+    class ReadGuard {
+    public:
+        explicit ReadGuard(const EpochManager& manager);
+        ~ReadGuard();
+        ReadGuard(const ReadGuard&)=delete;
+        ReadGuard& operator=(const ReadGuard&)=delete;
+    private:
+        const EpochManager& manager;
+        int slot;
+        bool outer;//最外层 guard 负责登记/清零
+    };
+
+    //写者：对象已从读者可见的结构中撤下，返回其退休纪元
+    uint64_t retire();
+    //退休纪元小于该值的对象可以安全回收
+    uint64_t safeEpoch() const;
+
+private:
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch{0};//0 表示不在临界区
+        int depth=0;//仅所属线程访问
+    };
+
+    std::atomic<uint64_t> globalEpoch{1};
+    mutable ReaderSlot readers[MAX_READERS];
+};
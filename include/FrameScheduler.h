@@ -0,0 +1,79 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+
+//==================== 主线程帧预算调度 ====================
+//主线程的零散工作（纹理上传、网格上传、新建 chunk、水模拟）按毫秒预算执行：
+//每帧 beginFrame 后，各任务用 begin 取得时间片，每做完一个单位调用 done，用 more() 判断下一个单位是否还放得下；
+//endFrame 按本帧实际工作耗时调整下一帧的总预算（慢于目标帧时间就收缩，有余量就放宽），
+//各任务按“每单位权重耗时”的滑动平均估算下一个单位，权重由任务给出（如网格上传按 KB 计）
+
+//一个任务在本帧的时间片
+class FrameSlice {
+public:
+    //不限时、最多 maxUnits 个单位（调度器之外的调用，如加载阶段的旧接口和测试）
+    explicit FrameSlice(int maxUnits);
+
+    //还能再做一个权重为 weight 的单位吗（未达保底单位数时总是可以）
+    bool more(double weight=1.0) const;
+    void done(double weight=1.0);
+    int getUnits() const { return units;}
+    int getMaxUnits() const { return maxUnits;}
+    double elapsedMs() const;
+
+private:
+    friend class FrameScheduler;
+    FrameSlice()=default;
+    int task=-1;
+    int minUnits=0,maxUnits=0;
+    double allowedMs=-1.0;//<0 表示不限时
+    double costPerWeight=0.0;//毫秒
+    int units=0;
+    double weight=0.0;
+    std::chrono::steady_clock::time_point start;
+};
+
+class FrameScheduler {
+public:
+    explicit FrameScheduler(double targetFrameMs=1000.0/60.0);
+
+    //share：与本帧尚未运行的其他任务按比例分剩余预算；minUnits：每帧保底；maxUnits：每帧上限
+    //initialCostMs：首帧之前对每单位权重耗时的估计
+    int addTask(const char* name,float share,int minUnits,int maxUnits,double initialCostMs);
+
+    void beginFrame();
+    FrameSlice begin(int task);
+    void end(const FrameSlice &slice);
+    //本帧工作结束（交换缓冲前调用）：按实际耗时调整下一帧预算，需要时打印本帧报告
+    void endFrame();
+
+    double getBudgetMs() const { return budgetMs;}
+    void setPrintEachFrame(bool v) { printEachFrame=v;}
+    bool getPrintEachFrame() const { return printEachFrame;}
+    //打印上次汇总以来各任务的平均/最大耗时与单位数，并清零统计
+    void printSummary();
+
+private:
+    struct Task {
+        std::string name;
+        float share;
+        int minUnits,maxUnits;
+        double costPerWeight;//每单位权重耗时的滑动平均（毫秒）
+        bool ranThisFrame=false;
+        double frameMs=0.0;
+        int frameUnits=0;
+        double sumMs=0.0,maxMs=0.0;
+        long long sumUnits=0;
+    };
+
+    std::vector<Task> tasks;
+    double targetFrameMs;
+    double budgetMs;
+    double usedMs=0.0;//本帧各时间片已用
+    std::chrono::steady_clock::time_point frameStart;
+    bool printEachFrame=false;
+    //汇总统计
+    long long frames=0;
+    double sumWorkMs=0.0,maxWorkMs=0.0,sumBudgetMs=0.0;
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include <functional>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+
+//==================== 工作窃取任务系统 ====================
+//每个工作线程一个双端队列：线程从自己队列的前端取任务，空闲时从其他线程队列的后端窃取
+//外部线程（主线程等）提交的任务轮流放入各队列；工作线程内提交的任务放入自己的队列
+//只在有线程休眠时才唤醒一个，提交不会惊醒所有线程
+//地形生成、网格构建、纹理解码共用 getJobSystem() 返回的实例
+class JobSystem {
+public:
+    typedef std::function<void()> Job;
+
+    //threadCount 为 0 时使用核心数-1（至少 1，主线程留给渲染）
+    explicit JobSystem(unsigned threadCount=0);
+    //停止并等待工作线程退出，尚未执行的任务直接丢弃（提交方应先等待自己的任务完成）
+    ~JobSystem();
+    JobSystem(const JobSystem&)=delete;
+    JobSystem& operator=(const JobSystem&)=delete;
+
+    void submit(Job job);
+    //阻塞直到已提交的任务全部执行完（不能在工作线程中调用）
+    void waitIdle();
+
+    unsigned getThreadCount() const { return static_cast<unsigned>(threads.size());}
+    //累计窃取次数（统计用）
+    size_t getStealCount() const { return steals.load(std::memory_order_relaxed);}
+
+private:
+    struct alignas(64) WorkerQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    bool tryPop(unsigned self,Job &out);
+    void workerMain(unsigned index);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<bool> running{true};
+    std::atomic<int> queuedJobs{0};    //各队列中尚未取出的任务数
+    std::atomic<int> unfinishedJobs{0};//已提交但未执行完的任务数
+    std::atomic<unsigned> nextQueue{0};//外部提交的轮转位置
+    std::atomic<size_t> steals{0};
+
+    std::mutex sleepMutex;
+    std::condition_variable sleepCv;
+    std::atomic<int> sleepers{0};
+    std::mutex idleMutex;
+    std::condition_variable idleCv;
+};
+
+//全局共享的任务系统（首次调用时创建，程序退出时销毁）
+JobSystem& getJobSystem();
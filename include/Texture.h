@@ -1,35 +1,39 @@
-#pragma once
-#include "Common.h"
-
-void loadBlockTextures();
-void loadPanoramaTextures();//ͳһԼȫȫͼ
-
-//
-void initPanoramaTextureHandles();
-bool loadPanoramaTextureIndex(int index);//ͬϴУ
-void requestPanoramaLoad(int index);//첽
-
-//
-void requestTitleTextureLoad();
-void initTitleTextureHandle();
-
-//
-void requestSubtitleTextureLoad();
-void initSubtitleTextureHandle();
-
-//
-void initBlockTextureHandles();
-bool loadBlockTextureIndex(int index);
-void requestBlockTextureLoad(int index);
-
-//첽̶̨߳ȡͼƬݣ߳Ӧ processPendingTextureUploads()  GL ϴ
-void startTextureLoader();
-void processPendingTextureUploads(int maxUploads=2);
-void stopTextureLoader();
-
-//ѯǷдϴͼƬ
-bool hasPendingTextureUploads();
-
-//
-void initSphereTextureHandle();
-void requestSphereTextureLoad();
+#pragma once
+#include "Common.h"
+#include "FrameScheduler.h"
+
+void loadBlockTextures();
+void loadPanoramaTextures();//传统一次性加载全部全景贴图
+
+//增量启动画面加载器
+void initPanoramaTextureHandles();
+bool loadPanoramaTextureIndex(int index);//同步加载请求将像素数据推入待上传队列）
+void requestPanoramaLoad(int index);//异步请求
+
+//标题纹理
+void requestTitleTextureLoad();
+void initTitleTextureHandle();
+
+//副标题纹理
+void requestSubtitleTextureLoad();
+void initSubtitleTextureHandle();
+
+//增量方块纹理加载器
+void initBlockTextureHandles();
+bool loadBlockTextureIndex(int index);
+void requestBlockTextureLoad(int index);
+
+//异步加载器：解码（SOIL）作为按优先级排队的任务在共享任务系统上执行，主线程应调用 processPendingTextureUploads() 进行 GL 上传
+//startTextureLoader 只确保任务系统已创建，stopTextureLoader 丢弃尚未执行的解码并等待进行中的解码结束
+void startTextureLoader();
+void processPendingTextureUploads(int maxUploads=2);
+//按时间片上传，单位权重为图片数据 KB；返回上传数量
+int processPendingTextureUploads(FrameSlice &slice);
+void stopTextureLoader();
+
+//查询是否有已请求但尚未上传的图片（包括仍在解码的）
+bool hasPendingTextureUploads();
+
+//球体纹理（足球）
+void initSphereTextureHandle();
+void requestSphereTextureLoad();
@@ -1,77 +1,336 @@
-#pragma once
-#include "Common.h"
-#include "Chunk.h"
-
-#include <thread>
-#include <mutex>
-#include <condition_variable>
-#include <queue>
-#include <atomic>
-
-class World {
-public:
-    World();
-    ~World();
-
-    Chunk* getChunk(int chunkX,int chunkZ);
-    BlockType getBlock(int x,int y,int z);
-    //ȡ鵫ȱʧchunkchunkδطAIR
-    BlockType getBlockIfLoaded(int x,int y,int z);
-    void setBlock(int x,int y,int z,BlockType type);
-
-    //ҪlightDirѡȾһµ
-    void updateChunks(const Camera& camera,const glm::vec3& lightDir);
-    void render(Shader& shader,const Camera& camera,const glm::vec3& lightDir);
-
-    //¶chunks/Ӱͨ
-    std::map<std::pair<int,int>,Chunk*>& getChunks() { return chunks;}
-
-    //Ƿں̨δ񣨵//ϴ
-    bool hasPendingWork() const;
-
-    // GL ̴߳Թ̵߳ϴ
-    void processUploads(int maxUploads=4);
-
-    //ָchunkǷѼ
-    bool hasChunkLoaded(int chunkX,int chunkZ) const;
-
-    //ʼɵ+ϴǷ
-    bool isInitialGenerationComplete();
-
-    //شterrain+build+uploads
-    int getPendingTasksCount() const;
-
-    //޵ˮģ,ӦԴѭ
-    void simulateWater(const Camera& camera);
-
-private:
-    std::map<std::pair<int,int>,Chunk*> chunks;
-    int renderDistance;
-
-    // chunk Ƿ׶ڣ޳
-    bool isChunkInFrustum(Chunk* chunk,const Camera& camera,const glm::mat4& viewProj) const;
-
-    //----- ߳ -----
-    struct BuildRequest {
-        Chunk* chunk;
-        glm::vec3 viewDir;
-        glm::vec3 lightDir;
-        bool full;//Ƿ񹹽 6 
-    };
-
-    std::mutex buildMutex;
-    std::condition_variable buildCv;
-    std::queue<BuildRequest> buildQueue;
-
-    //ɶУ߳̽ɵβMeshData
-    std::queue<Chunk*> terrainQueue;
-
-    std::mutex uploadMutex;
-    std::queue<MeshData> uploadQueue;
-
-    std::vector<std::thread> workers;
-    std::atomic<bool> workerRunning{false};
-    int maxUploadsPerFrame=8;
-    //ÿ֡½chunkԱCPUֵ
-    int maxNewChunksPerFrame=4;
-};
\ No newline at end of file
+#pragma once
+#include "Common.h"
+#include "Chunk.h"
+#include "ChunkPool.h"
+#include "ChunkGrid.h"
+#include "EpochManager.h"
+
+#include "JobSystem.h"
+#include "FrameScheduler.h"
+
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <chrono>
+
+//World::readBox 的结果：闭区间 [min,max] 内方块的稠密拷贝，按 (y,z,x) 顺序存放
+struct BlockBox {
+    glm::ivec3 min=glm::ivec3(0),max=glm::ivec3(-1);
+    std::vector<BlockType> blocks;
+
+    bool contains(int x,int y,int z) const { return x>=min.x && x<=max.x && y>=min.y && y<=max.y && z>=min.z && z<=max.z;}
+    //box 外返回 AIR
+    BlockType get(int x,int y,int z) const { return contains(x,y,z) ? blocks[index(x,y,z)] : AIR;}
+    int index(int x,int y,int z) const { return ((y-min.y)*(max.z-min.z+1)+(z-min.z))*(max.x-min.x+1)+(x-min.x);}
+};
+
+//查询落在未加载 chunk 上时的处理方式
+//chunk 只应由 updateChunks 按视距流式创建；物理/模拟探测应使用 AS_AIR 或 AS_SOLID
+enum UnloadedPolicy {
+    UNLOADED_AS_AIR,  //视为空气
+    UNLOADED_AS_SOLID,//视为实心（STONE），碰撞时用它把玩家/球体挡在已加载区域内
+    UNLOADED_CREATE   //创建 chunk 并排队生成地形（计入 streamer 外创建计数）
+};
+
+class BlockCursor;
+
+class World {
+public:
+    World();
+    ~World();
+
+    //取 chunk，不存在时创建（计入 streamer 外创建计数）
+    Chunk* getChunk(int chunkX,int chunkZ);
+    //以下查询（除 tryGetBlock/getBlockIfLoaded/hasChunkLoaded 外）只应在主线程调用
+    BlockType getBlock(int x,int y,int z,UnloadedPolicy policy);
+    //区分“未加载”：chunk 未加载时返回 false，out 不变（无锁，可在工作线程调用）
+    bool tryGetBlock(int x,int y,int z,BlockType &out) const;
+    //获取方块但不创建缺失的chunk。若chunk未加载返回AIR（无锁，可在工作线程调用）
+    BlockType getBlockIfLoaded(int x,int y,int z) const;
+    //写入方块；chunk 未加载时丢弃修改并返回 false（不会创建 chunk）
+    bool setBlock(int x,int y,int z,BlockType type);
+
+    //把闭区间 [min,max] 内的方块一次性拷贝到 out（每个 chunk 只查找、加锁一次）
+    //未加载的 chunk 按 policy 处理，世界高度范围外为 AIR
+    void readBox(const glm::ivec3& min,const glm::ivec3& max,BlockBox& out,UnloadedPolicy policy);
+
+    //列查询：直接读取区块维护的高度图/列掩码，未加载的 chunk 按 policy 处理
+    bool isColumnLoaded(int x,int z) const;
+    //最高实心方块的 y，整列无实心方块或地形尚未生成时返回 -1
+    int getTopSolidY(int x,int z,UnloadedPolicy policy);
+    //从 baseY 开始连续 64 格的列掩码，第 i 位对应 baseY+i（AS_SOLID 时未加载列在世界高度内全为实心、无流体）
+    ColumnMask getSolidColumn(int x,int z,int baseY,UnloadedPolicy policy);
+    ColumnMask getFluidColumn(int x,int z,int baseY,UnloadedPolicy policy);
+    bool isSolidAt(int x,int y,int z,UnloadedPolicy policy);
+    bool isFluidAt(int x,int y,int z,UnloadedPolicy policy);
+
+    //updateChunks 之外创建的 chunk 数量（应接近 0，非 0 说明有查询绕过了流式加载策略）
+    size_t getChunksCreatedOutsideStreamer() const { return chunksCreatedOutsideStreamer;}
+
+    //网格与视角、光照无关（面方向剔除在渲染时按相机位置进行），lightDir 保留给调用方但不再影响构建
+    void updateChunks(const Camera& camera,const glm::vec3& lightDir);
+    //新建 chunk 的数量由时间片决定（每新建一个调用一次 creation.done）
+    void updateChunks(const Camera& camera,const glm::vec3& lightDir,FrameSlice &creation);
+    void render(Shader& shader,const Camera& camera,const glm::vec3& lightDir);
+
+    //暴露chunks以用于深度/阴影通道（可直接 range-for 遍历存活 chunk）
+    const ChunkGrid& getChunks() const { return chunks;}
+
+    //返回是否存在后台未完成任务（地形/构建/上传）
+    bool hasPendingWork() const;
+
+    //等待单个 chunk 到达流水线阶段：stage 为 CHUNK_GENERATED（地形已生成）、CHUNK_MESH_READY（首个网格已构建）
+    //或 CHUNK_UPLOADED（首个网格已上传）。chunk 不存在时立即创建并排队生成。
+    //回调只在主线程调用：已到达时在本调用内立即调用，否则在之后的 processUploads/updateChunks 中调用；
+    //参数为该 chunk，若 chunk 在到达前被驱逐（离开流式加载范围）则为 nullptr
+    typedef std::function<void(Chunk*)> ChunkCallback;
+    void requestChunk(int chunkX,int chunkZ,ChunkState stage,ChunkCallback onReady);
+
+    //在主 GL 线程处理有限数量来自工作线程的网格上传（render 不再上传，由调用方在渲染前调用）
+    void processUploads(int maxUploads=4);
+    //按时间片上传，单位权重为顶点数据 KB；返回上传数量
+    int processUploads(FrameSlice &slice);
+
+    //检查指定坐标的chunk是否已加载（无锁，可在工作线程调用）
+    bool hasChunkLoaded(int chunkX,int chunkZ) const;
+
+    //检查初始生成地形+网格上传是否完成
+    bool isInitialGenerationComplete();
+
+    //返回待处理任务总数（terrain+build+uploads）
+    int getPendingTasksCount() const;
+
+    //在相机附近运行一次水模拟（调用频率由主循环按实际时间决定）
+    void simulateWater(const Camera& camera);
+
+    //打印常驻区块方块数据的内存报告（与旧版 int 枚举三维数组对比）
+    void printMemoryReport() const;
+
+    //chunk 对象池（可调整高水位、查看命中统计）
+    ChunkPool& getChunkPool() { return chunkPool;}
+
+    //对比环形网格与 std::map 的 chunk 查找耗时（按当前常驻 chunk 构造同样的 map，命中/未命中各半）
+    void benchmarkChunkLookup() const;
+    //网格争用基准：在所有核心上反复构建含水最多的常驻 chunk 的网格，对比无锁目录与旧的持调度锁查找（基准内模拟调度与主线程扫描持锁）
+    void benchmarkMeshContention();
+    //任务系统扩展性基准：1、2、4…直到核心数个线程分别生成+构建一批 chunk，打印每秒 chunk 数
+    void benchmarkJobScaling() const;
+    //网格构建基准：常驻 chunk 上对比逐方块与位掩码两种网格构建的耗时，并检查两者输出逐字节相同（含随机改动的快照）
+    void benchmarkMesher();
+    //网格分配基准：按工作线程的路径构建 1000 次网格，分快照/构建/移交三个阶段打印每 chunk 的堆分配次数与字节数
+    void benchmarkMeshAllocations();
+
+private:
+    int renderDistance;
+    int evictionRadius;//超出该 chunk 距离（切比雪夫距离）的 chunk 被驱逐
+    ChunkGrid chunks;//覆盖整个驱逐范围的环形网格
+    ChunkPool chunkPool;//getChunk 从池中取，驱逐时归还
+
+    friend class BlockCursor;
+
+    //创建 chunk 并排队生成地形（调用方确认该坐标尚无 chunk）
+    Chunk* createChunk(int chunkX,int chunkZ);
+    size_t chunksCreatedOutsideStreamer=0;
+    //按 policy 取 chunk：CREATE 时不存在则创建，否则未加载返回 nullptr
+    Chunk* chunkAt(int chunkX,int chunkZ,UnloadedPolicy policy);
+    //世界方块坐标 -> 所在 chunk 与 chunk 内局部坐标
+    Chunk* chunkForColumn(int x,int z,int &localX,int &localZ,UnloadedPolicy policy);
+
+    //----- 工作线程的无锁 chunk 目录 -----
+    //读者（tryGetBlock 等）在纪元临界区内用 ChunkGrid::findConcurrent 查找；
+    //驱逐的 chunk 先从网格撤下并记录退休纪元，待所有可能看到它的读者退出后再归还对象池
+    EpochManager directoryEpochs;
+    std::vector<std::pair<Chunk*,uint64_t>> retiredChunks;
+    void reclaimRetiredChunks();
+    Chunk* findChunkConcurrent(int chunkX,int chunkZ) const;
+    //网格构建的输入：chunk 自身加四周已生成邻居的一格边界（可在工作线程调用）
+    void snapshotForMeshing(const Chunk* c,MeshSnapshot &out) const;
+
+    //检查 chunk 是否在视锥内（用于剔除）
+    bool isChunkInFrustum(Chunk* chunk,const Camera& camera,const glm::mat4& viewProj) const;
+
+    //----- 多线程网格生成相关 -----
+    struct BuildRequest {
+        ChunkHandle chunk;
+        bool urgent=false;//方块编辑触发：排在所有流式加载的任务与上传之前
+    };
+
+    //地形/网格任务先按优先级放入 scheduled 堆，再向共享任务系统（getJobSystem）提交同样数量的执行令牌：
+    //每个令牌执行时取出当前优先级最高的任务，因此相机移动后重新打分即可改变执行顺序
+    //地形任务只生成地形，网格由依赖检查（见 meshWaiting）在四周邻居就绪后提交
+    struct ScheduledTask {
+        float priority;//越小越先（见 chunkPriority）
+        bool terrain;
+        uint32_t epoch;//提交时 chunk 的任务纪元，不一致说明已被取消
+        BuildRequest req;//地形任务只使用 req.chunk
+    };
+    std::mutex scheduleMutex;
+    std::vector<ScheduledTask> scheduled;//按 priority 的最小堆
+    static bool laterTask(const ScheduledTask &a,const ScheduledTask &b) { return a.priority>b.priority;}
+    void submitTerrainJob(Chunk* c);
+    void submitBuildJob(const BuildRequest &req);
+    void schedule(ScheduledTask task);
+    //工作线程：取出并执行优先级最高的任务
+    void runScheduledTask();
+    //相机移动/转向超过阈值时重新打分并重建堆，同时移除已取消的任务（主线程）
+    void rescoreScheduled();
+    //----- 过时任务取消 -----
+    //chunk 在任务完成前离开生成半径（外加 CANCEL_MARGIN_CHUNKS 的滞后）时，主线程 cancelJobs 使其任务纪元前进：
+    //任务在出堆前、地形生成各阶段之间、构建网格后检查纪元，放弃后把 chunk 交回主线程标为延后，回到视距内再重新提交
+    enum CancelStage {
+        CANCEL_QUEUED,        //执行前（仍在堆中或刚出堆）
+        CANCEL_TERRAIN,       //地形生成途中
+        CANCEL_AFTER_MESH,    //网格已构建，丢弃结果不上传
+        CANCEL_UPLOAD,        //结果已在上传队列，上传前丢弃
+        CANCEL_STAGE_COUNT
+    };
+    static constexpr int CANCEL_MARGIN_CHUNKS=1;
+    std::atomic<size_t> cancelledJobs[CANCEL_STAGE_COUNT]={};
+    std::atomic<long long> jobWorkUs{0};   //地形/网格任务累计耗时（微秒）
+    std::atomic<long long> wastedWorkUs{0};//其中最终被丢弃的部分
+    std::vector<ChunkHandle> cancelledChunks;//由 uploadMutex 保护，processUploads 中处理
+    //工作线程：记录取消并把 chunk 交回主线程（释放任务计数）
+    void cancelTask(ScheduledTask &task,CancelStage stage);
+    //提交并计入 outstandingJobs；析构开始后任务不再执行实际工作
+    void submitJob(std::function<void()> job);
+    std::atomic<int> pendingTerrainJobs{0};
+    std::atomic<int> pendingBuildJobs{0};
+    std::atomic<int> outstandingJobs{0};
+    std::atomic<bool> shuttingDown{false};
+
+    //待上传的网格：持有 chunk 引用，上传前 chunk 不会被驱逐
+    //每帧按当前优先级挑选上传，同一 chunk 的多份结果按产生顺序（sequence）上传
+    struct PendingUpload {
+        ChunkHandle chunk;
+        MeshData data;
+        uint64_t sequence=0;
+        uint32_t epoch=0;//产生该结果的任务纪元
+        bool urgent=false;//同 BuildRequest::urgent
+    };
+    std::mutex uploadMutex;
+    std::vector<PendingUpload> uploadQueue;
+    uint64_t uploadSequence=0;//由 uploadMutex 保护
+    //主线程：在途任务被取消的 chunk 标为延后并恢复状态
+    void processCancelled();
+    void deferCancelled(Chunk* c);
+    void pushUpload(PendingUpload &&upload);
+    //在 GL 线程上传一条网格并推进状态
+    void uploadPending(PendingUpload &upload);
+    //取出优先级最高的至多 maxUploads 条上传
+    void takeBestUploads(int maxUploads,std::vector<PendingUpload> &batch);
+
+    //requestChunk 的等待列表（只在主线程访问）
+    struct ChunkRequest {
+        int chunkX,chunkZ;
+        ChunkState stage;
+        ChunkCallback onReady;
+    };
+    std::vector<ChunkRequest> chunkRequests;
+    void processChunkRequests();
+    //主线程：把 chunk 的完整重建加入构建队列（已在队列中时忽略并返回 false）
+    bool requestRebuild(Chunk* c,bool urgent=false);
+
+    //----- 方块编辑的异步重建 -----
+    //setBlock 只写方块并记下 chunk（触及边界时连同共享面的邻居），updateChunks 开头统一提交高优先级的完整重建：
+    //同一帧内对同一 chunk 的多次编辑只重建一次，重建完成前继续显示旧网格
+    //构建开始后又被编辑的结果照常上传（仍比旧网格新），上传时发现编辑版本落后再补建一次
+    std::vector<ChunkHandle> editedChunks;//主线程；持有引用，提交前不会被驱逐
+    void noteEdit(Chunk* c,bool neighbour);
+    void flushEdits();
+    //已在堆中、尚未开始的构建提到编辑优先级
+    void promoteBuild(Chunk* c);
+    //编辑统计：编辑提交的重建数、构建后又被编辑而补建的次数、编辑到网格上传的延迟
+    size_t editRemeshes=0,staleEditMeshes=0,editLatencySamples=0;
+    double editLatencySumMs=0.0,editLatencyMaxMs=0.0;
+    //上一帧视锥内 chunk 的不透明四边形：按面方向剔除后实际提交的数量与总数
+    size_t opaqueQuadsDrawn=0,opaqueQuadsTotal=0;
+
+    //不带时间片的 updateChunks 每帧新建 chunk 的上限（按优先级挑选）
+    int maxNewChunksPerFrame=4;
+
+    //----- 生成 -> 网格 的依赖 -----
+    //地形比网格多生成 MESH_MARGIN_CHUNKS 圈（generationRadius），视距内 chunk 的四个邻居因此总会生成
+    //地形生成完成的 chunk 进入 meshWaiting，在视距内且四个水平邻居都“就绪”后才提交首次网格构建：
+    //邻居已生成地形，或不会再生成（不在生成半径内且未创建、或已被取消延后）
+    //视距内等待超过 MAX_NEIGHBOUR_WAIT_FRAMES 帧则按缺失边界先构建，之后由邻居生成事件补建
+    //邻居晚到（生成完成）时，只重建网格缺这一侧的相邻 chunk
+    struct MeshWait {
+        ChunkHandle chunk;//持有引用：等待期间不会被驱逐
+        uint64_t sinceFrame;//最近一次进入视距的帧
+    };
+    static constexpr int MESH_MARGIN_CHUNKS=1;
+    static constexpr int MAX_NEIGHBOUR_WAIT_FRAMES=30;
+    int generationRadius() const { return renderDistance+MESH_MARGIN_CHUNKS;}
+    size_t meshWaitingInView=0;//meshWaiting 中位于视距内的数量（计入待处理任务）
+    std::vector<ChunkHandle> generatedChunks;//工作线程生成完成的 chunk，由 uploadMutex 保护
+    std::vector<MeshWait> meshWaiting;//主线程
+    uint64_t frameIndex=0;//updateChunks 调用次数
+    void processGenerated();
+    void awaitNeighbours(Chunk* c);
+    //检查等待中的 chunk：就绪或超时的提交网格构建，离开视距的延后（主线程）
+    void updateMeshDependencies(int playerChunkX,int playerChunkZ);
+    //网格统计：首次上传的 chunk 数、完成的网格构建数、邻居晚到触发的重建数、超时未等齐邻居就构建的次数
+    size_t chunksMeshed=0,meshBuilds=0,borderRemeshes=0,forcedMeshes=0;
+
+    //----- 调度优先级（主线程） -----
+    //越小越先：到相机的水平距离（chunk 数），视锥外按偏离视线的角度放大；脚下附近的 chunk 不看方向
+    //网格要等四周邻居生成，因此邻居的优先级不低于“它再远一个 chunk”：可见 chunk 的邻居不会因在视锥外而拖住它
+    float chunkPriority(int chunkX,int chunkZ) const;
+    //任务/上传的优先级：编辑触发的减去 EDIT_PRIORITY_BOOST，排在所有流式加载之前（彼此仍按距离）
+    static constexpr float EDIT_PRIORITY_BOOST=1.0e6f;
+    float buildPriority(const Chunk* c,bool urgent) const;
+    float viewPriority(int chunkX,int chunkZ) const;
+    bool isInViewCone(int chunkX,int chunkZ) const;
+    glm::vec3 viewPos=glm::vec3(0.0f),viewFront=glm::vec3(0.0f,0.0f,-1.0f);//最近一次 updateChunks 的相机
+    glm::vec3 scoredPos=glm::vec3(0.0f),scoredFront=glm::vec3(0.0f,0.0f,-1.0f);//scheduled 上次打分时的相机
+
+    //----- 出生/传送后首次看到地面的耗时 -----
+    //出生或单帧移动超过 TELEPORT_CHUNKS 个 chunk 时开始计时：
+    //ground=脚下 chunk 的网格已上传；nearView=NEAR_VIEW_RADIUS 内视锥中的 chunk 网格全部上传
+    struct GroundTimer {
+        bool active=false;
+        const char* reason="";
+        std::chrono::steady_clock::time_point start;
+        int frames=0;
+        double groundMs=-1.0;
+        int groundFrames=0;
+    };
+    static constexpr int TELEPORT_CHUNKS=4;
+    static constexpr int NEAR_VIEW_RADIUS=3;
+    GroundTimer groundTimer;
+    bool viewInitialized=false;
+    int lastPlayerChunkX=0,lastPlayerChunkZ=0;
+    double lastGroundMs=-1.0,lastNearViewMs=-1.0;//最近一次的结果（F3 报告）
+    //updateChunks 中检测出生/传送并计帧，processUploads 之后检查是否完成
+    void updateGroundTimer(int playerChunkX,int playerChunkZ);
+    void checkGroundTimer();
+};
+
+//==================== 方块访问游标 ====================
+//记住上一次解析到的 chunk：连续访问落在同一 chunk 内时跳过网格查找，只做移位/掩码换算；只在主线程使用，读方块不加锁
+//未加载的 chunk 返回什么由构造时的 UnloadedPolicy 决定，只有 UNLOADED_CREATE 会创建 chunk。只在单次调用范围内使用（如一次水模拟），
+//不要跨帧保存：updateChunks 可能驱逐缓存的 chunk
+class BlockCursor {
+public:
+    BlockCursor(World& world,UnloadedPolicy policy) : world(world),policy(policy) {}
+
+    BlockType get(int x,int y,int z) {
+        int chunkX=ChunkLayout::chunkOfX(x),chunkZ=ChunkLayout::chunkOfZ(z);
+        if(!resolved || chunkX!=cachedX || chunkZ!=cachedZ) {
+            //未加载也缓存（cached==nullptr），同一 chunk 内的后续访问不再查找
+            cached=world.chunkAt(chunkX,chunkZ,policy);
+            cachedX=chunkX;
+            cachedZ=chunkZ;
+            resolved=true;
+        }
+        if(!cached) return (policy==UNLOADED_AS_SOLID && y>=0 && y<getWorldHeight()) ? STONE : AIR;
+        return cached->getBlockOnMainThread(ChunkLayout::localX(x),y,ChunkLayout::localZ(z));
+    }
+
+private:
+    World& world;
+    UnloadedPolicy policy;
+    Chunk* cached=nullptr;
+    bool resolved=false;
+    int cachedX=0,cachedZ=0;
+};
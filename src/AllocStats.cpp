@@ -0,0 +1,48 @@
+#include "../include/AllocStats.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef YC_ALLOC_STATS
+namespace {
+    //常量初始化，早于任何动态初始化中的分配
+    std::atomic<size_t> allocCount{0};
+    std::atomic<size_t> allocBytes{0};
+
+    void* countedAlloc(size_t size) {
+        allocCount.fetch_add(1,std::memory_order_relaxed);
+        allocBytes.fetch_add(size,std::memory_order_relaxed);
+        for(;;) {
+            if(void* p=std::malloc(size ? size : 1)) return p;
+            std::new_handler handler=std::get_new_handler();
+            if(!handler) throw std::bad_alloc();
+            handler();
+        }
+    }
+}
+
+AllocCounts getAllocCounts() {
+    return { allocCount.load(std::memory_order_relaxed),allocBytes.load(std::memory_order_relaxed) };
+}
+
+void* operator new(size_t size) { return countedAlloc(size);}
+void* operator new[](size_t size) { return countedAlloc(size);}
+void* operator new(size_t size,const std::nothrow_t&) noexcept {
+    try { return countedAlloc(size);}
+    catch(...) { return nullptr;}
+}
+void* operator new[](size_t size,const std::nothrow_t&) noexcept {
+    try { return countedAlloc(size);}
+    catch(...) { return nullptr;}
+}
+void operator delete(void* p) noexcept { std::free(p);}
+void operator delete[](void* p) noexcept { std::free(p);}
+void operator delete(void* p,size_t) noexcept { std::free(p);}
+void operator delete[](void* p,size_t) noexcept { std::free(p);}
+void operator delete(void* p,const std::nothrow_t&) noexcept { std::free(p);}
+void operator delete[](void* p,const std::nothrow_t&) noexcept { std::free(p);}
+#else
+AllocCounts getAllocCounts() {
+    return { 0,0 };
+}
+#endif
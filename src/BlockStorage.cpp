@@ -0,0 +1,185 @@
+#include "../include/BlockStorage.h"
+
+namespace {
+    //每个 32 位字可容纳的条目数的 log2（bits=1/2/4/8 -> 5/4/3/2）
+    inline int entriesPerWordShift(int bits) {
+        switch (bits) {
+        case 1: return 5;
+        case 2: return 4;
+        case 4: return 3;
+        default: return 2;
+        }
+    }
+}
+
+PalettedContainer::PalettedContainer() : bits(0),paletteCount(1) {
+    palette[0]=AIR;
+}
+
+int PalettedContainer::bitsForCount(int distinct) {
+    if(distinct<=1) return 0;
+    if(distinct<=2) return 1;
+    if(distinct<=4) return 2;
+    if(distinct<=16) return 4;
+    return 8;
+}
+
+BlockType PalettedContainer::get(int index) const {
+    if(bits==0) return palette[0];
+    int shift=entriesPerWordShift(bits);
+    uint32_t word=data[index>>shift];
+    int bitOffset=(index&((1<<shift)-1))*bits;
+    uint32_t v=(word>>bitOffset)&((1u<<bits)-1u);
+    if(bits==8) return static_cast<BlockType>(v);
+    return palette[v];
+}
+
+int PalettedContainer::findOrAddPalette(BlockType type) {
+    for(int i=0;i<paletteCount;++i)
+        if(palette[i]==type) return i;
+    //复用已不再出现的项（计数为 0），不必扩大位宽
+    for(int i=0;i<paletteCount;++i)
+        if(counts[i]==0) {
+            palette[i]=type;
+            return i;
+        }
+    int newCount=paletteCount+1;
+    if(newCount>16) {
+        //调色板溢出：退回每方块一字节
+        repack(8);
+        return -1;
+    }
+    palette[paletteCount]=type;
+    counts[paletteCount]=0;
+    paletteCount=static_cast<uint8_t>(newCount);
+    if(newCount>(1<<bits)) {
+        //旧索引在新调色板中保持不变，只需按新位宽重新打包
+        BlockType dense[VOLUME];
+        unpack(dense);
+        bits=static_cast<uint8_t>(bitsForCount(newCount));
+        int shift=entriesPerWordShift(bits);
+        data.assign(VOLUME>>shift,0u);
+        uint8_t lut[256]={ 0 };
+        for(int i=0;i<paletteCount;++i) lut[palette[i]]=static_cast<uint8_t>(i);
+        for(int i=0;i<VOLUME;++i) {
+            int bitOffset=(i&((1<<shift)-1))*bits;
+            data[i>>shift] |= static_cast<uint32_t>(lut[dense[i]])<<bitOffset;
+        }
+    }
+    return paletteCount-1;
+}
+
+void PalettedContainer::set(int index,BlockType type) {
+    if(bits==0) {
+        if(palette[0]==type) return;
+        //均匀区段写入第一个不同的方块：直接建立 1 位调色板
+        palette[1]=type;
+        paletteCount=2;
+        bits=1;
+        data.assign(VOLUME>>5,0u);
+        data[index>>5] |= 1u<<(index&31);
+        counts[0]=static_cast<uint16_t>(VOLUME-1);
+        counts[1]=1;
+        return;
+    }
+    int pi=(bits==8) ? -1 : findOrAddPalette(type);
+    int shift=entriesPerWordShift(bits);
+    int bitOffset=(index&((1<<shift)-1))*bits;
+    uint32_t mask=((1u<<bits)-1u)<<bitOffset;
+    uint32_t v=(bits==8) ? static_cast<uint32_t>(type) : static_cast<uint32_t>(pi);
+    uint32_t &word=data[index>>shift];
+    uint32_t old=(word&mask)>>bitOffset;
+    word=(word&~mask)|(v<<bitOffset);
+    if(bits==8 || old==v) return;
+    //某项计数归零且剩余项能用更小位宽表示时立即压缩，否则留作空闲项供下次复用
+    if(--counts[old]==0) {
+        int live=0;
+        for(int i=0;i<paletteCount;++i)
+            if(counts[i]>0 || i==pi) ++live;
+        if(bitsForCount(live)<bits) {
+            compact();
+            return;
+        }
+    }
+    ++counts[pi];
+}
+
+void PalettedContainer::fill(BlockType type) {
+    bits=0;
+    paletteCount=1;
+    palette[0]=type;
+    std::vector<uint32_t>().swap(data);
+}
+
+void PalettedContainer::unpack(BlockType* dst) const {
+    if(bits==0) {
+        for(int i=0;i<VOLUME;++i) dst[i]=palette[0];
+        return;
+    }
+    int shift=entriesPerWordShift(bits);
+    int perWord=1<<shift;
+    uint32_t mask=(1u<<bits)-1u;
+    for(int w=0;w<(VOLUME>>shift);++w) {
+        uint32_t word=data[w];
+        for(int e=0;e<perWord;++e) {
+            uint32_t v=(word>>(e*bits))&mask;
+            dst[(w<<shift)+e]=(bits==8) ? static_cast<BlockType>(v) : palette[v];
+        }
+    }
+}
+
+void PalettedContainer::load(const BlockType* src) {
+    uint32_t tally[256]={ 0 };
+    paletteCount=0;
+    int distinct=0;
+    for(int i=0;i<VOLUME;++i) {
+        uint8_t t=static_cast<uint8_t>(src[i]);
+        if(tally[t]++) continue;
+        if(distinct<16) palette[distinct]=src[i];
+        ++distinct;
+    }
+    bits=static_cast<uint8_t>(bitsForCount(distinct));
+    paletteCount=static_cast<uint8_t>(distinct>16 ? 0 : distinct);
+    if(bits==0) {
+        std::vector<uint32_t>().swap(data);
+        return;
+    }
+    uint8_t lut[256]={ 0 };
+    for(int i=0;i<paletteCount;++i) {
+        lut[palette[i]]=static_cast<uint8_t>(i);
+        counts[i]=static_cast<uint16_t>(tally[palette[i]]);
+    }
+    int shift=entriesPerWordShift(bits);
+    std::vector<uint32_t> packed(VOLUME>>shift,0u);
+    for(int i=0;i<VOLUME;++i) {
+        uint32_t v=(bits==8) ? static_cast<uint32_t>(src[i]) : lut[src[i]];
+        int bitOffset=(i&((1<<shift)-1))*bits;
+        packed[i>>shift] |= v<<bitOffset;
+    }
+    data.swap(packed);
+}
+
+void PalettedContainer::repack(int newBits) {
+    BlockType dense[VOLUME];
+    unpack(dense);
+    if(newBits==8) {
+        bits=8;
+        paletteCount=0;
+        std::vector<uint32_t> packed(VOLUME>>2,0u);
+        for(int i=0;i<VOLUME;++i) packed[i>>2] |= static_cast<uint32_t>(dense[i])<<((i&3)*8);
+        data.swap(packed);
+        return;
+    }
+    load(dense);
+}
+
+void PalettedContainer::compact() {
+    if(bits==0) return;
+    BlockType dense[VOLUME];
+    unpack(dense);
+    load(dense);
+}
+
+size_t PalettedContainer::memoryBytes() const {
+    return sizeof(*this)+data.capacity()*sizeof(uint32_t);
+}
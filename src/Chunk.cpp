@@ -1,1091 +1,1325 @@
-#include "../include/Chunk.h"
-#include "../include/Common.h"
-#include "../include/Shader.h"
-#include "../include/World.h"
-
-// ȫ worldڿ߽ѯھ
-extern World world;
-
-namespace {
-    //ˮƽ̴С굥λƣ
-    constexpr float WATER_TILE_SIZE=2.0f;//2x2 鹲һͼ
-
-    //һ㣨λáuvߣд뻺
-    inline void pushVertex(std::vector<float> &buf,const glm::vec3 &pos,const glm::vec2 &uv,const glm::vec3 &normal) {
-        //λ (3)
-        buf.push_back(pos.x);
-        buf.push_back(pos.y);
-        buf.push_back(pos.z);
-        // (2)
-        buf.push_back(uv.x);
-        buf.push_back(uv.y);
-        // (3)
-        buf.push_back(normal.x);
-        buf.push_back(normal.y);
-        buf.push_back(normal.z);
-    }
-
-    //ĳĳ
-    inline glm::vec2 computeTexCoords(BlockType type,int face,const glm::vec3 &worldPos,int vi,const float texProto[12]) {
-        if(type==WATER && face==4) {
-            //ˮʹ UVʹ chunk 
-            float uf=worldPos.x/WATER_TILE_SIZE;
-            float vf=worldPos.z/WATER_TILE_SIZE;
-            //ȡС֣̰ıβֵαӰ GL_REPEAT ƽ
-            return glm::vec2(uf,vf);
-        }
-        //Ĭʹֲ texProtoٷת V
-        int ti=vi*2;
-        float u=texProto[ti];
-        float v=texProto[ti+1];
-        return glm::vec2(u,v);
-    }
-}
-
-//캯ʼΪ AIR VAO/VBO
-Chunk::Chunk(int x,int z) : chunkX(x),chunkZ(z),needsUpdate(true),isFullMesh(false),pendingBuild(false),gpuLoaded(false) {
-    //ʼΪ
-    for(int xi=0;xi<CHUNK_SIZE;++xi)
-        for(int y=0;y<CHUNK_HEIGHT;++y)
-            for(int zi=0;zi<CHUNK_SIZE;++zi)
-                blocks[xi][y][zi]=AIR;
-
-    //  GL Դӳٵϴʱ chunk ʱ
-    // glGenVertexArrays(NUM_BLOCK_TEXTURES, VAOs);
-    // glGenBuffers(NUM_BLOCK_TEXTURES, VBOs);
-}
-
-//ͷ OpenGL Դ
-Chunk::~Chunk() {
-    if(gpuLoaded) {
-        glDeleteVertexArrays(NUM_BLOCK_TEXTURES,VAOs);
-        glDeleteBuffers(NUM_BLOCK_TEXTURES,VBOs);
-    }
-}
-
-// ȷ GPU Դڣ GL ̵߳ã
-void Chunk::ensureGpuLoaded() {
-    if(gpuLoaded) return;
-    glGenVertexArrays(NUM_BLOCK_TEXTURES,VAOs);
-    glGenBuffers(NUM_BLOCK_TEXTURES,VBOs);
-    gpuLoaded=true;
-}
-
-//ȡͣԽ緵 AIR
-BlockType Chunk::getBlock(int x,int y,int z) const {
-    if(x<0 || x>=CHUNK_SIZE || y<0 || y>=CHUNK_HEIGHT || z<0 || z>=CHUNK_SIZE) return AIR;
-    return blocks[x][y][z];
-}
-
-//÷鲢Ҫؽ
-void Chunk::setBlock(int x,int y,int z,BlockType type) {
-    if(x<0 || x>=CHUNK_SIZE || y<0 || y>=CHUNK_HEIGHT || z<0 || z>=CHUNK_SIZE) return;
-    blocks[x][y][z]=type;
-    needsUpdate=true;
-}
-
-//ݷͷػɫڵ/ͼʱ
-glm::vec3 Chunk::getBlockColor(BlockType type) {
-    switch (type) {
-        case GRASS: return glm::vec3(0.4f,0.8f,0.3f);
-        case DIRT:  return glm::vec3(0.6f,0.4f,0.2f);
-        case STONE: return glm::vec3(0.5f);
-        case WOOD:  return glm::vec3(0.6f,0.3f,0.1f);
-        case LEAVES:return glm::vec3(0.2f,0.6f,0.2f);
-        case CLOUD: return glm::vec3(1.0f,1.0f,1.0f);
-        case SAND:  return glm::vec3(0.9f,0.9f,0.6f);
-        case WATER: return glm::vec3(0.2f,0.4f,0.8f);
-        default:    return glm::vec3(1.0f);
-    }
-}
-
-//ɵΣһ߶ͼڶ鰴߶ȺȺϵ䷽
-void Chunk::generateTerrain() {
-    //һ飺Ϊǰ chunk ߶ͼ
-    int heightMap[CHUNK_SIZE][CHUNK_SIZE];
-    for(int cx=0;cx<CHUNK_SIZE;++cx) {
-        for(int cz=0;cz<CHUNK_SIZE;++cz) {
-            float worldX=static_cast<float>(chunkX*CHUNK_SIZE+cx);
-            float worldZ=static_cast<float>(chunkZ*CHUNK_SIZE+cz);
-            float h=calculateTerrainHeight(worldX,worldZ);
-            int terrainHeight=static_cast<int>(h);
-            //ӹȵ
-            float riverNoise=octavePerlin(worldX,worldZ,3,0.5f,2.0f,RIVER_FREQ);
-            float riverBand=std::abs(riverNoise);
-            if(riverBand<RIVER_WIDTH) {
-                float t=1.0f-(riverBand/RIVER_WIDTH);
-                int carve=static_cast<int>(std::round(t*RIVER_DEPTH));
-                if(terrainHeight-carve>WATER_LEVEL-5)
-                    terrainHeight=std::max(WATER_LEVEL,terrainHeight-carve);
-				else terrainHeight =  terrainHeight - carve;
-            }
-            heightMap[cx][cz]=terrainHeight;
-        }
-    }
-
-    //ڶ飺ݸ߶ͼȺϵֱ䷽
-	int WATERH = WATER_LEVEL-1;
-    BlockType blocksCache[CHUNK_SIZE][CHUNK_SIZE],blocksCache2[CHUNK_SIZE][CHUNK_SIZE];
-    for(int cx=0;cx<CHUNK_SIZE;++cx) {
-        for(int cz=0;cz<CHUNK_SIZE;++cz) {
-            float worldX=static_cast<float>(chunkX*CHUNK_SIZE+cx);
-            float worldZ=static_cast<float>(chunkZ*CHUNK_SIZE+cz);
-            int terrainHeight=heightMap[cx][cz];
-
-            float riverNoise=octavePerlin(worldX,worldZ,3,0.5f,2.0f,RIVER_FREQ);
-            float riverBand=std::abs(riverNoise);
-            bool isRiver=(riverBand<RIVER_WIDTH);
-
-            BiomeType biome=getBiome(worldX,worldZ,terrainHeight);
-
-            for(int y=0;y<CHUNK_HEIGHT;++y) {
-                if(y<terrainHeight-5) {
-                    blocks[cx][y][cz]=STONE;
-                } else if(y<terrainHeight-1) {
-                    blocks[cx][y][cz]=DIRT;
-                } else if(y<terrainHeight) {
-                    if(isRiver && terrainHeight<=WATER_LEVEL+2) {
-                        blocks[cx][y][cz]=SAND;
-                    } else if(biome==BIOME_BEACH || biome==BIOME_DESERT || biome==BIOME_OCEAN) {
-                        blocks[cx][y][cz]=SAND;
-                    } else if(biome==BIOME_SNOW || biome==BIOME_MOUNTAINS) {
-                        blocks[cx][y][cz]=STONE;
-                    } else {
-                        blocks[cx][y][cz]=GRASS;
-                    }
-                } else {
-                    blocks[cx][y][cz]=AIR;
-                }
-            }
-
-            //εˮ棬ˮֱˮλ
-            if (terrainHeight < WATER_LEVEL) {
-                for (int y = terrainHeight; y < WATER_LEVEL && y < CHUNK_HEIGHT; ++y) {
-                    blocks[cx][y][cz] = WATER;
-                }
-                blocksCache[cx][cz] = WATER;
-            }else{
-                blocksCache[cx][cz]=blocks[cx][WATERH][cz];
-            }
-        }
-    }
-
-    //ʴ
-    int dx[8]={-1,-1,-1,0,0,1,1,1};
-    int dz[8]={-1,0,1,-1,1,-1,0,1};
-    memcpy(blocksCache2, blocksCache, sizeof(blocksCache));
-    for(int cx=0;cx<CHUNK_SIZE;++cx) {
-        for(int cz=0;cz<CHUNK_SIZE;++cz) {
-            if (blocksCache2[cx][cz]!=WATER) {
-                for(int dir=0;dir<8;++dir) {
-                    int nx=cx+dx[dir];
-                    int nz=cz+dz[dir];
-                    if(nx>=0&&nx<CHUNK_SIZE&&nz>=0&&nz<CHUNK_SIZE&&blocksCache[nx][nz]==WATER) {
-						blocksCache2[cx][cz]=WATER;
-						break;
-                    }
-				}
-            }
-        }
-    }
-    for(int cx=0;cx<CHUNK_SIZE;++cx) {
-        for(int cz=0;cz<CHUNK_SIZE;++cz) {
-            if(blocksCache[cx][cz]==WATER){
-                for(int dir=0;dir<8;++dir) {
-                    int nx=cx+dx[dir];
-                    int nz=cz+dz[dir];
-                    if(nx>=0&&nx<CHUNK_SIZE&&nz>=0&&nz<CHUNK_SIZE&&blocksCache2[nx][nz]!=WATER) {
-                        blocksCache[cx][cz]=blocks[nx][WATERH][nz];
-						break;
-                    }
-                }
-            }
-        }
-    }
-    for(int cx=0;cx<CHUNK_SIZE;++cx) {
-        for(int cz=0;cz<CHUNK_SIZE;++cz) {
-            if(blocksCache[cx][cz]!=WATER) {
-                if(cx-1>= 0)blocksCache2[cx-1][cz]=SAND;
-                if(cx+1<CHUNK_SIZE)blocksCache2[cx+1][cz]=SAND;
-                if(cz-1>=0)blocksCache2[cx][cz-1]=SAND;
-                if(cz+1<CHUNK_SIZE)blocksCache2[cx][cz+1]=SAND;
-            }
-        }
-    }
-    memcpy(blocksCache, blocksCache2, sizeof(blocksCache));
-    for(int cx=0;cx<CHUNK_SIZE;++cx) {
-        for(int cz=0;cz<CHUNK_SIZE;++cz) {
-            if(blocksCache2[cx][cz]==WATER) {
-                if(cx-1>= 0)blocksCache[cx-1][cz]=WATER;
-                if(cx+1<CHUNK_SIZE)blocksCache[cx+1][cz]=WATER;
-                if(cz-1 >=0)blocksCache[cx][cz-1]=WATER;
-                if(cz+1<CHUNK_SIZE)blocksCache[cx][cz+1]=WATER;
-            }
-        }
-    }
-    for(int cx=0; cx<CHUNK_SIZE; ++cx) {
-        for(int cz=0; cz<CHUNK_SIZE; ++cz) {
-			blocks[cx][WATERH][cz]=blocksCache[cx][cz];
-        }
-    }
-
-    //ɣڲݵϰȺϵɣWOODڣLEAVES
-    for(int cx=0;cx<CHUNK_SIZE;++cx) {
-        for(int cz=0;cz<CHUNK_SIZE;++cz) {
-            float worldX=static_cast<float>(chunkX*CHUNK_SIZE+cx);
-            float worldZ=static_cast<float>(chunkZ*CHUNK_SIZE+cz);
-            int topY=heightMap[cx][cz];
-            if(topY<=0 || topY>=CHUNK_HEIGHT-8) continue;//ռ
-            int groundY=topY-1;
-            if(groundY<0) continue;
-            if(blocks[cx][groundY][cz]!=GRASS) continue;//ֻڲݷ
-
-            BiomeType biome=getBiome(worldX,worldZ,topY);
-
-            //ڿ chunk Եֹڿ chunk и
-            const int borderMargin=4;//Ӧ>=Ҷڰ뾶
-            if(cx<borderMargin || cz<borderMargin || cx>=CHUNK_SIZE-borderMargin || cz>=CHUNK_SIZE-borderMargin) continue;
-            //Use a deterministic per-cell hash RNG to avoid large coherent patches from low-frequency noise.
-            //Keep Perlin to modulate some variability,but make placement primarily probabilistic per cell.
-            float treeNoise=octavePerlin(worldX*0.25f+77.0f,worldZ*0.25f+91.0f,3,0.5f,2.0f,0.6f);
-            //lower base probabilities to reduce overall tree density
-            float spawnProb=0.0005f;
-            if(biome==BIOME_FOREST) spawnProb=0.004f;//still denser in forests but not overcrowded
-            else if(biome==BIOME_PLAINS) spawnProb=0.001f;
-            else if(biome==BIOME_DESERT || biome==BIOME_BEACH || biome==BIOME_OCEAN) spawnProb=0;
-            if(spawnProb<=0.0f) continue;
-
-            // ȷԹϣ -> [0,1)
-            float h = std::sin(worldX * 12.9898f + worldZ * 78.233f) * 43758.5453f;
-            float cellRand = h - std::floor(h);
-
-            // ΢ɸ
-            float noiseFactor = 1.5f + 0.5f * treeNoise; // ~[0,1]
-            float effectiveProb = spawnProb * (0.5f + noiseFactor * 0.5f);
-            if (cellRand >= effectiveProb) continue; // 
-
-            //  chunk ڽɵùڿ
-            const int minDist = 3; // С
-            bool tooClose = false;
-            int nx0 = std::max(0, cx - minDist);
-            int nx1 = std::min(CHUNK_SIZE - 1, cx + minDist);
-            int nz0 = std::max(0, cz - minDist);
-            int nz1 = std::min(CHUNK_SIZE - 1, cz + minDist);
-            int checkTop = std::min(CHUNK_HEIGHT - 1, topY + 6);
-            for (int nx = nx0; nx <= nx1 && !tooClose; ++nx) {
-                for (int nz = nz0; nz <= nz1; ++nz) {
-                    for (int yy = topY; yy <= checkTop; ++yy) {
-                        BlockType b = blocks[nx][yy][nz];
-                        if (b == WOOD || b == LEAVES) { tooClose = true; break; }
-                    }
-                    if(tooClose) break;
-                }
-            }
-            if(tooClose) continue;
-
-            //ɸ߶ȣͻ׼Сɱ䷶ΧʹС
-            float hNoise=octavePerlin(worldX*0.17f+600.0f,worldZ*0.17f+600.0f,2,0.5f,2.0f,0.8f);
-            //base 3,variable ~0..2 -> typical heights ~3..5
-            int trunkH=4+static_cast<int>((hNoise+1.0f)*2.0f);
-            trunkH=std::min(trunkH,CHUNK_HEIGHT-4-topY);
-            bool canPlace=true;
-            for(int y=topY;y<topY+trunkH;++y) {
-                if(y>=CHUNK_HEIGHT || blocks[cx][y][cz]!=AIR) { canPlace=false;break;}
-            }
-            if(!canPlace) continue;
-            for(int y=topY;y<topY+trunkH;++y) blocks[cx][y][cz]=WOOD;
-
-            int leafBase=topY+trunkH-1;
-            //Ҷڣ/ֲ
-            for(int lx=-3;lx<=3;++lx) {
-                for(int lz=-3;lz<=3;++lz) {
-                    for(int ly=0;ly<=3;++ly) {
-                        int ax=cx+lx;
-                        int ay=leafBase+ly;
-                        int az=cz+lz;
-                        if(ax<0 || ax>=CHUNK_SIZE || ay<0 || ay>=CHUNK_HEIGHT || az<0 || az>=CHUNK_SIZE) continue;
-                        float dist2=(float)lx*lx+(float)lz*lz+(float)ly*ly*0.7f;
-                        //СֵҶչ
-                        if(dist2<=11.5f) {
-                            if(blocks[ax][ay][az]==AIR) blocks[ax][ay][az]=LEAVES;
-                        }
-                    }
-                }
-            }
-        }
-    }
-
-    //===  ===
-    const int CLOUD_BASE=CHUNK_HEIGHT-1;
-    const int CLOUD_THICKNESS=1;
-    const float CLOUD_SCALE=0.04f;
-    const float CLOUD_THRESHOLD=0.38f;
-    for(int cx=0;cx<CHUNK_SIZE;++cx) {
-        for(int cz=0;cz<CHUNK_SIZE;++cz) {
-            float worldX=static_cast<float>(chunkX*CHUNK_SIZE+cx);
-            float worldZ=static_cast<float>(chunkZ*CHUNK_SIZE+cz);
-            float n=octavePerlin(worldX*CLOUD_SCALE,worldZ*CLOUD_SCALE,3,0.5f,2.0f,1.0f);
-            if(n>CLOUD_THRESHOLD) {
-                for(int cy=0;cy<CLOUD_THICKNESS;++cy) {
-                    int y=CLOUD_BASE+cy;
-                    if(y>=0 && y<CHUNK_HEIGHT && blocks[cx][y][cz]==AIR) blocks[cx][y][cz]=CLOUD;
-                }
-            }
-        }
-    }
-
-    needsUpdate=true;
-}
-
-//Ϊָָ㣨ΣдӦĶ㻺
-void Chunk::addFace(float x,float y,float z,int face,BlockType type) {
-    //ѡۣݷ鶥/ײ/ʹòۣͬ
-    int texIndex=-1;
-    if(type==GRASS) {
-        if(face==4) texIndex=0;      //ݶ
-        else if(face==5) texIndex=1; //ײʹ
-        else texIndex=7;                //ʹ grass_side
-    } else {
-        texIndex=blockTypeToTexIndex(type);
-    }
-    if(texIndex<0) return;
-
-    //ÿĶԭͣ6 㣬ÿ 3 
-    static const float v[6][18]={
-        {0,0,1,1,0,1,1,1,1,  1,1,1,0,1,1,0,0,1},//ǰ
-        {1,0,0,0,0,0,0,1,0,  0,1,0,1,1,0,1,0,0},//
-        {0,0,0,0,0,1,0,1,1,  0,1,1,0,1,0,0,0,0},//
-        {1,0,1,1,0,0,1,1,0,  1,1,0,1,1,1,1,0,1},//
-        {0,1,1,1,1,1,1,1,0,  1,1,0,0,1,0,0,1,1},//
-        {0,0,0,1,0,0,1,0,1,  1,0,1,0,0,1,0,0,0} //
-    };
-
-    static const glm::vec3 normals[6]={
-        glm::vec3(0,0,1),glm::vec3(0,0,-1),glm::vec3(-1,0,0),glm::vec3(1,0,0),glm::vec3(0,1,0),glm::vec3(0,-1,0)
-    };
-
-    static const float texProto[12]={ 0,0,1,0,1,1,1,1,0,1,0,0 };
-
-    auto &buf=verticesByType[texIndex];
-    glm::vec3 normal=normals[face];
-
-    //ɸ 6 
-    for(int vi=0;vi<6;++vi) {
-        int pi=vi*3;
-        glm::vec3 pos(x+v[face][pi],y+v[face][pi+1],z+v[face][pi+2]);
-        glm::vec2 uv=computeTexCoords(type,face,pos,vi,texProto);
-        pushVertex(buf,pos,uv,normal);
-    }
-}
-
-//ĳǷɼ Greedy Meshing
-bool Chunk::isFaceVisible(int x,int y,int z,int face,BlockType blockType) const {
-     if(blockType==AIR) return false;
-	 if(blockType==LEAVES)return true;
-
-    // ھλòжھǷڱ chunk 
-    int wx = chunkX * CHUNK_SIZE + x;
-    int wz = chunkZ * CHUNK_SIZE + z;
-    int nLocalX = x, nLocalY = y, nLocalZ = z;
-    int nChunkX = chunkX, nChunkZ = chunkZ;
-    switch (face) {
-        case 0: nLocalZ=z+1;
-            if(nLocalZ>=CHUNK_SIZE) { 
-                nLocalZ=0;
-                nChunkZ=chunkZ+1;
-            } 
-            break;//+Z
-        case 1: nLocalZ=z-1;
-            if(nLocalZ<0) { 
-                nLocalZ=CHUNK_SIZE-1;
-                nChunkZ=chunkZ-1;
-            } 
-            break;//-Z
-        case 2: nLocalX=x-1;
-            if(nLocalX<0) { 
-                nLocalX=CHUNK_SIZE-1;
-                nChunkX=chunkX-1;
-            } 
-            break;//-X
-        case 3: nLocalX=x+1;
-            if(nLocalX>=CHUNK_SIZE) {
-                nLocalX=0;
-                nChunkX=chunkX+1;
-            } 
-            break;//+X
-        case 4: 
-            nLocalY=y+1;
-            break; //+Y (Y is global within chunk)
-        case 5: 
-            nLocalY=y-1;
-            break; //-Y
-        default: 
-            return false;
-    }
-
-    BlockType neighbor = AIR;
-    if (nChunkX == chunkX && nChunkZ == chunkZ) {
-        // ھͬһ chunk -> پֲѯ
-        neighbor = getBlock(nLocalX, nLocalY, nLocalZ);
-    } else {
-        // ھڲͬ chunkˮˮǽִпҡ
-        if (blockType == WATER) {
-            int nx = nChunkX * CHUNK_SIZE + nLocalX;
-            int nz = nChunkZ * CHUNK_SIZE + nLocalZ;
-            // ھ chunk δ/شھˮԱ
-            if (!world.hasChunkLoaded(nChunkX, nChunkZ)) {
-                // Ƴٷֱھ chunk ˮǽ
-                neighbor = WATER; // Ϊˮᷢ
-            } else {
-                neighbor=world.getBlockIfLoaded(nx,nLocalY,nz);
-            }
-         } else {
-             //assume absent neighbor (treat as AIR) to avoid expensive cross-chunk lookups foropaque blocks
-             neighbor=AIR;
-         }
-    }
-
-    return (neighbor==AIR || (blockType!=WATER && neighbor==WATER));
-}
-
-// һϲĴıΣwidth  height 飩
-void Chunk::addQuad(float x,float y,float z,int width,int height,int face,BlockType type) {
-    //ѡ
-    int texIndex=-1;
-    if(type==GRASS) {
-        if(face==4) texIndex=0;      //ݶ
-        else if(face==5) texIndex=1; //ײʹ
-        else texIndex=7;                //ʹ grass_side
-    } else {
-        texIndex=blockTypeToTexIndex(type);
-    }
-    if(texIndex<0) return;
-
-    auto &buf=verticesByType[texIndex];
-    
-    //淨
-    static const glm::vec3 normals[6]={
-        glm::vec3(0,0,1),glm::vec3(0,0,-1),glm::vec3(-1,0,0),
-        glm::vec3(1,0,0),glm::vec3(0,1,0),glm::vec3(0,-1,0)
-    };
-    glm::vec3 normal=normals[face];
-    
-    //ķıε4
-    glm::vec3 v0,v1,v2,v3;
-    glm::vec2 uv0,uv1,uv2,uv3;
-    
-    switch (face) {
-        case 0: //ǰ +Z
-            v0=glm::vec3(x,y,z+1);
-            v1=glm::vec3(x+width,y,z+1);
-            v2=glm::vec3(x+width,y+height,z+1);
-            v3=glm::vec3(x,y+height,z+1);
-            uv0=glm::vec2(0,0);
-            uv1=glm::vec2(width,0);
-            uv2=glm::vec2(width,height);
-            uv3=glm::vec2(0,height);
-            break;
-        case 1: // -Z
-            v0=glm::vec3(x+width,y,z);
-            v1=glm::vec3(x,y,z);
-            v2=glm::vec3(x,y+height,z);
-            v3=glm::vec3(x+width,y+height,z);
-            uv0=glm::vec2(0,0);
-            uv1=glm::vec2(width,0);
-            uv2=glm::vec2(width,height);
-            uv3=glm::vec2(0,height);
-            break;
-        case 2: // -X
-            v0=glm::vec3(x,y,z);
-            v1=glm::vec3(x,y,z+width);
-            v2=glm::vec3(x,y+height,z+width);
-            v3=glm::vec3(x,y+height,z);
-            uv0=glm::vec2(0,0);
-            uv1=glm::vec2(width,0);
-            uv2=glm::vec2(width,height);
-            uv3=glm::vec2(0,height);
-            break;
-        case 3: // +X
-            v0=glm::vec3(x+1,y,z+width);
-            v1=glm::vec3(x+1,y,z);
-            v2=glm::vec3(x+1,y+height,z);
-            v3=glm::vec3(x+1,y+height,z+width);
-            uv0=glm::vec2(0,0);
-            uv1=glm::vec2(width,0);
-            uv2=glm::vec2(width,height);
-            uv3=glm::vec2(0,height);
-            break;
-        case 4: // +Yָԭʼ˳Ա޳һ£
-            v0=glm::vec3(x,y+1,z+height);
-            v1=glm::vec3(x+width,y+1,z+height);
-            v2=glm::vec3(x+width,y+1,z);
-            v3=glm::vec3(x,y+1,z);
-            uv0=glm::vec2(0,0);
-            uv1=glm::vec2(width,0);
-            uv2=glm::vec2(width,height);
-            uv3=glm::vec2(0,height);
-            break;
-        case 5: // -Y
-            v0=glm::vec3(x,y,z);
-            v1=glm::vec3(x+width,y,z);
-            v2=glm::vec3(x+width,y,z+height);
-            v3=glm::vec3(x,y,z+height);
-            uv0=glm::vec2(0,0);
-            uv1=glm::vec2(width,0);
-            uv2=glm::vec2(width,height);
-            uv3=glm::vec2(0,height);
-            break;
-    }
-    
-    //ˮ⴦ʹUV
-    if(type==WATER && face==4) {
-        //ֱ/ fract ֵαӰ
-        float uf0=v0.x/WATER_TILE_SIZE;
-        float vf0=v0.z/WATER_TILE_SIZE;
-        float uf1=v1.x/WATER_TILE_SIZE;
-        float vf1=v1.z/WATER_TILE_SIZE;
-        float uf2=v2.x/WATER_TILE_SIZE;
-        float vf2=v2.z/WATER_TILE_SIZE;
-        float uf3=v3.x/WATER_TILE_SIZE;
-        float vf3=v3.z/WATER_TILE_SIZE;
-        
-        uv0=glm::vec2(uf0,vf0);
-        uv1=glm::vec2(uf1,vf1);
-        uv2=glm::vec2(uf2,vf2);
-        uv3=glm::vec2(uf3,vf3);
-    } else {
-        //ͨ飺ƽ
-        uv1.x=uv2.x=static_cast<float>(width);
-        uv2.y=uv3.y=static_cast<float>(height);
-    }
-    
-    //Σ6㣩ı
-    //1: v0,v1,v2
-    buf.push_back(v0.x);
-    buf.push_back(v0.y);
-    buf.push_back(v0.z);
-    buf.push_back(uv0.x);
-    buf.push_back(uv0.y);
-    buf.push_back(normal.x);
-    buf.push_back(normal.y);
-    buf.push_back(normal.z);
-    
-    buf.push_back(v1.x);
-    buf.push_back(v1.y);
-    buf.push_back(v1.z);
-    buf.push_back(uv1.x);
-    buf.push_back(uv1.y);
-    buf.push_back(normal.x);
-    buf.push_back(normal.y);
-    buf.push_back(normal.z);
-    
-    buf.push_back(v2.x);
-    buf.push_back(v2.y);
-    buf.push_back(v2.z);
-    buf.push_back(uv2.x);
-    buf.push_back(uv2.y);
-    buf.push_back(normal.x);
-    buf.push_back(normal.y);
-    buf.push_back(normal.z);
-    
-    //2: v2,v3,v0
-    buf.push_back(v2.x);
-    buf.push_back(v2.y);
-    buf.push_back(v2.z);
-    buf.push_back(uv2.x);
-    buf.push_back(uv2.y);
-    buf.push_back(normal.x);
-    buf.push_back(normal.y);
-    buf.push_back(normal.z);
-    
-    buf.push_back(v3.x);
-    buf.push_back(v3.y);
-    buf.push_back(v3.z);
-    buf.push_back(uv3.x);
-    buf.push_back(uv3.y);
-    buf.push_back(normal.x);
-    buf.push_back(normal.y);
-    buf.push_back(normal.z);
-    
-    buf.push_back(v0.x);
-    buf.push_back(v0.y);
-    buf.push_back(v0.z);
-    buf.push_back(uv0.x);
-    buf.push_back(uv0.y);
-    buf.push_back(normal.x);
-    buf.push_back(normal.y);
-    buf.push_back(normal.z);
-}
-
-//Greedy Meshing 㷨
-void Chunk::buildGreedyMesh(const glm::vec3* viewDir,const glm::vec3* lightDir) {
-    //֮ǰĶ
-    for(int i=0;i<NUM_BLOCK_TEXTURES;++i) verticesByType[i].clear();
-
-    //ȷҪ
-    bool checkFace[6]={false,false,false,false,false,false};
-    
-    if(viewDir==nullptr && lightDir==nullptr) {
-        for(int i=0;i<6;++i) checkFace[i]=true;
-        isFullMesh=true;
-    } else {
-        isFullMesh=false;
-        if(viewDir!=nullptr) {
-            checkFace[viewDir->z>0.0f ? 0 : 1]=true;
-            checkFace[viewDir->x>0.0f ? 3 : 2]=true;
-            checkFace[viewDir->y>0.0f ? 4 : 5]=true;
-        }
-        if(lightDir!=nullptr) {
-            checkFace[lightDir->z>0.0f ? 0 : 1]=true;
-            checkFace[lightDir->x>0.0f ? 3 : 2]=true;
-            checkFace[lightDir->y>0.0f ? 4 : 5]=true;
-        }
-    }
-
-    //ÿ淽ִ Greedy Meshing
-    for(int face=0;face<6;++face) {
-        if(!checkFace[face]) continue;
-        
-        //飺¼ЩĸѾϲ
-        bool merged[CHUNK_SIZE][CHUNK_HEIGHT][CHUNK_SIZE]={{{false}}};
-        
-        //ķȷ˳
-        int dim1,dim2,dim3; //ά
-        int size1,size2,size3;
-        
-        //淽0=ǰ+Z,1=-Z,2=-X,3=+X,4=+Y,5=-Y
-        if(face==0 || face==1) {  //Z
-            dim1=0;dim2=1;dim3=2; //X,Y,Z
-            size1=CHUNK_SIZE;
-            size2=CHUNK_HEIGHT;
-            size3=CHUNK_SIZE;
-        } else if(face==2 || face==3) {  //X
-            dim1=2;dim2=1;dim3=0; //Z,Y,X
-            size1=CHUNK_SIZE;
-            size2=CHUNK_HEIGHT;
-            size3=CHUNK_SIZE;
-        } else {  //Y
-            dim1=0;dim2=2;dim3=1; //X,Z,Y
-            size1=CHUNK_SIZE;
-            size2=CHUNK_SIZE;
-            size3=CHUNK_HEIGHT;
-        }
-        
-        //ɨ÷в
-        for(int d3=0;d3<size3;++d3) {
-            for(int d2=0;d2<size2;++d2) {
-                for(int d1=0;d1<size1;++d1) {
-                    //ת x,y,z 
-                    int x,y,z;
-                    if(face==0 || face==1) {
-                        x=d1;y=d2;z=d3;
-                    } else if(face==2 || face==3) {
-                        x=d3;y=d2;z=d1;
-                    } else {
-                        x=d1;y=d3;z=d2;
-                    }
-                    
-                    //Ѿϲ
-                    if(merged[x][y][z]) continue;
-                    
-                    BlockType blockType=blocks[x][y][z];
-                    if(blockType==AIR) continue;
-                    if(!isFaceVisible(x,y,z,face,blockType)) continue;
-                    
-                    // ͸/ alpha ķ飨 LEAVES, CLOUD̰ϲ
-                    // ϲܲƽ渲򣬵 alpha Ե
-                    if (blockType == LEAVES || blockType == CLOUD) {
-                        merged[x][y][z] = true;
-                        // 
-                        float wx = static_cast<float>(chunkX * CHUNK_SIZE + x);
-                        float wy = static_cast<float>(y);
-                        float wz = static_cast<float>(chunkZ * CHUNK_SIZE + z);
-                        addFace(wx, wy, wz, face, blockType);
-                        continue;
-                    }
-
-                    //ʼ̰չ
-                    //1.  dim1 չȣ
-                    int width=1;
-                    while (d1+width<size1) {
-                        int nx,ny,nz;
-                        if(face==0 || face==1) {
-                            nx=d1+width;ny=d2;nz=d3;
-                        } else if(face==2 || face==3) {
-                            nx=d3;ny=d2;nz=d1+width;
-                        } else {
-                            nx=d1+width;ny=d3;nz=d2;
-                        }
-                        
-                        if(merged[nx][ny][nz]) break;
-                        if(blocks[nx][ny][nz]!=blockType) break;
-                        if(!isFaceVisible(nx,ny,nz,face,blockType)) break;
-                        
-                        width++;
-                    }
-                    
-                    //2.  dim2 չ߶ȣ
-                    int height=1;
-                    bool canExtend=true;
-                    while (d2+height<size2 && canExtend) {
-                        //езǷ񶼿Ժϲ
-                        for(int w=0;w<width;++w) {
-                            int nx,ny,nz;
-                            if(face==0 || face==1) {
-                                nx=d1+w;
-                                ny=d2+height;
-                                nz=d3;
-                            } else if(face==2 || face==3) {
-                                nx=d3;
-                                ny=d2+height;
-                                nz=d1+w;
-                            } else {
-                                nx=d1+w;
-                                ny=d3;
-                                nz=d2+height;
-                            }
-                            
-                            if(merged[nx][ny][nz] || 
-                                blocks[nx][ny][nz]!=blockType ||
-                                !isFaceVisible(nx,ny,nz,face,blockType)) {
-                                canExtend=false;
-                                break;
-                            }
-                        }
-                        if(canExtend) height++;
-                    }
-                    
-                    //3. кϲķ
-                    for(int h=0;h<height;++h) {
-                        for(int w=0;w<width;++w) {
-                            int nx,ny,nz;
-                            if(face==0 || face==1) {
-                                nx=d1+w;
-                                ny=d2+h;
-                                nz=d3;
-                            } else if(face==2 || face==3) {
-                                nx=d3;
-                                ny=d2+h;
-                                nz=d1+w;
-                            } else {
-                                nx=d1+w;
-                                ny=d3;
-                                nz=d2+h;
-                            }
-                            merged[nx][ny][nz]=true;
-                        }
-                    }
-                    
-                    //4. ɺϲĴı
-                    float wx=static_cast<float>(chunkX*CHUNK_SIZE+x);
-                    float wy=static_cast<float>(y);
-                    float wz=static_cast<float>(chunkZ*CHUNK_SIZE+z);
-                    addQuad(wx,wy,wz,width,height,face,blockType);
-                }
-            }
-        }
-    }
-
-    needsUpdate=false;
-}
-
-//Ϊ chunk 񣨰飩ϴ GPU
-void Chunk::buildMesh(const glm::vec3* viewDir,const glm::vec3* lightDir) {
-    //񣬱ѡ浼ȱʧ¶
-    buildGreedyMesh(nullptr,nullptr);
-    ensureGpuLoaded();
-
-    //ÿĶϴ GPUöָ
-    for(int i=0;i<NUM_BLOCK_TEXTURES;++i) {
-        glBindVertexArray(VAOs[i]);
-        glBindBuffer(GL_ARRAY_BUFFER,VBOs[i]);
-        if(!verticesByType[i].empty()) {
-            glBufferData(GL_ARRAY_BUFFER,verticesByType[i].size()*sizeof(float),verticesByType[i].data(),GL_STATIC_DRAW);
-            int stride=8*sizeof(float);//pos(3) tex(2) normal(3)
-            glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,stride,(void*)0);
-            glEnableVertexAttribArray(0);
-            glVertexAttribPointer(1,2,GL_FLOAT,GL_FALSE,stride,(void*)(3*sizeof(float)));
-            glEnableVertexAttribArray(1);
-            glVertexAttribPointer(2,3,GL_FLOAT,GL_FALSE,stride,(void*)(5*sizeof(float)));
-            glEnableVertexAttribArray(2);
-        }
-    }
-}
-
-//Ⱦÿ󶨶Ӧ
-void Chunk::renderOpaque(Shader &shader,const glm::vec3* lightDir) {
-    if(needsUpdate && !pendingBuild) buildMesh(nullptr,lightDir);
-
-    //Opaque pass: draw all non-transparent texture groups and update depth buffer
-    for(int i=0;i<NUM_BLOCK_TEXTURES;++i) {
-        //indices 4=leaves,6=water,8=cloud are transparent and should not be in opaque pass
-        if(i==4 || i==6 || i==8) continue;
-        if(verticesByType[i].empty()) continue;
-        float specular=0.1f;
-        if(i==6) specular=1.0f;
-        else if(i==5 || i==0 || i==7) specular=0.0f;
-        else if(i==2) specular=0.05f;
-        shader.setFloat("specularStrength",specular);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D,blockTextures[i]);
-        glBindVertexArray(VAOs[i]);
-        glDrawArrays(GL_TRIANGLES,0,static_cast<GLsizei>(verticesByType[i].size()/8));
-    }
-}
-
-//Note: per-chunk transparent draw is unused when World performs global sorting.
-void Chunk::renderTransparent(Shader &shader,const glm::vec3* viewDir,const glm::vec3* cameraPos,const glm::vec3* lightDir) {
-}
-
-void Chunk::renderDepth(Shader &depthShader) {
-    if((needsUpdate || !isFullMesh) && !pendingBuild) {
-        buildMesh(nullptr,nullptr);
-    }
-    
-    for(int i=0;i<NUM_BLOCK_TEXTURES;++i) {
-        if(verticesByType[i].empty()) continue;
-        glBindVertexArray(VAOs[i]);
-        glDrawArrays(GL_TRIANGLES,0,static_cast<GLsizei>(verticesByType[i].size()/8));
-    }
-}
-
-//New: CPU-only mesh generation returning MeshData (safe to call from worker thread)
-MeshData Chunk::buildMeshCPU(const glm::vec3* viewDir,const glm::vec3* lightDir) {
-    MeshData out;out.chunkX=chunkX;out.chunkZ=chunkZ;
-    std::vector<float> tempBuffers[NUM_BLOCK_TEXTURES];
-    //Always process all 6 faces forCPU mesh
-    for(int face=0;face<6;++face) {
-        bool merged[CHUNK_SIZE][CHUNK_HEIGHT][CHUNK_SIZE]={{{false}}};
-        int size1,size2,size3;//traversal dimensions mapping
-        if(face==0 || face==1) { 
-            size1=CHUNK_SIZE;
-            size2=CHUNK_HEIGHT;
-            size3=CHUNK_SIZE;
-        }else if(face==2 || face==3) {
-            size1=CHUNK_SIZE;
-            size2=CHUNK_HEIGHT;
-            size3=CHUNK_SIZE;
-        }else { 
-            size1=CHUNK_SIZE;
-            size2=CHUNK_SIZE;
-            size3=CHUNK_HEIGHT;
-        }
-        for(int d3=0;d3<size3;++d3) {
-            for(int d2=0;d2<size2;++d2) {
-                for(int d1=0;d1<size1;++d1) {
-                    int x,y,z;
-                    if(face==0 || face==1) {
-                        x=d1;y=d2;z=d3;
-                    }else if(face==2 || face==3) {
-                        x=d3;y=d2;z=d1;
-                    }else{ x=d1;y=d3;z=d2;}
-                    if(merged[x][y][z]) continue;
-                    BlockType bt=blocks[x][y][z];
-                    if(bt==AIR) continue;
-                    if(!isFaceVisible(x,y,z,face,bt)) continue;
-                    //width expansion
-                    int width=1;
-                    while (d1+width<size1) {
-                        int nx,ny,nz;
-                        if(face==0||face==1){ 
-                            nx=d1+width;
-                            ny=d2;
-                            nz=d3;
-                        } else if(face==2||face==3){ 
-                            nx=d3;
-                            ny=d2;
-                            nz=d1+width;
-                        } else {
-                            nx=d1+width;
-                            ny=d3;
-                            nz=d2;
-                        }
-                        if(merged[nx][ny][nz]) break;
-                        if(blocks[nx][ny][nz]!=bt) break;
-                        if(!isFaceVisible(nx,ny,nz,face,bt)) break;
-                        ++width;
-                    }
-                    //height expansion
-                    int height=1;
-                    bool canExtend=true;
-                    while(canExtend && d2+height<size2) {
-                        for(int w=0;w<width;++w){ 
-                            int nx,ny,nz;
-                            if(face==0||face==1){ 
-                                nx=d1+w;
-                                ny=d2+height;
-                                nz=d3;
-                            } else if(face==2||face==3){
-                                nx=d3;
-                                ny=d2+height;
-                                nz=d1+w;
-                            } else { 
-                                nx=d1+w;
-                                ny=d3;
-                                nz=d2+height;
-                            }
-                            if(merged[nx][ny][nz] || blocks[nx][ny][nz]!=bt || !isFaceVisible(nx,ny,nz,face,bt)){ 
-                                canExtend=false;
-                                break;
-                            }
-                        }
-                        if(canExtend) ++height;
-                    }
-                    //mark merged
-                    for(int h=0;h<height;++h){ 
-                        for(int w=0;w<width;++w){
-                            int nx,ny,nz;
-                            if(face==0||face==1){ 
-                                nx=d1+w;
-                                ny=d2+h;
-                                nz=d3;
-                            } else if(face==2||face==3){ 
-                                nx=d3;
-                                ny=d2+h;
-                                nz=d1+w;
-                            } else {
-                                nx=d1+w;
-                                ny=d3;
-                                nz=d2+h;
-                            } merged[nx][ny][nz]=true;
-                        }
-                    }
-                    //emit quad
-                    float wx=static_cast<float>(chunkX*CHUNK_SIZE+x);
-                    float wy=static_cast<float>(y);
-                    float wz=static_cast<float>(chunkZ*CHUNK_SIZE+z);
-                    //local quad generation (duplicate of addQuad simplified)
-                    int texIndex=-1;
-                    if(bt==GRASS){
-                        if(face==4) texIndex=0;
-                        else if(face==5) texIndex=1;
-                        else texIndex=7;
-                    } else texIndex=blockTypeToTexIndex(bt);
-                    if(texIndex<0) continue;
-                    auto &buf=tempBuffers[texIndex];
-                    static const glm::vec3 normals[6]={ {0,0,1},{0,0,-1},{-1,0,0},{1,0,0},{0,1,0},{0,-1,0} };
-                    glm::vec3 normal=normals[face];
-                    glm::vec3 v0,v1,v2,v3;
-                    switch(face){
-                        case 0: v0={wx,wy,wz+1};
-                            v1={wx+width,wy,wz+1};
-                            v2={wx+width,wy+height,wz+1};
-                            v3={wx,wy+height,wz+1};
-                            break;
-                        case 1: 
-                            v0={wx+width,wy,wz};
-                            v1={wx,wy,wz};
-                            v2={wx,wy+height,wz};
-                            v3={wx+width,wy+height,wz};
-                            break;
-                        case 2: 
-                            v0={wx,wy,wz};
-                            v1={wx,wy,wz+width};
-                            v2={wx,wy+height,wz+width};
-                            v3={wx,wy+height,wz};
-                            break;
-                        case 3:
-                            v0={wx+1,wy,wz+width};
-                            v1={wx+1,wy,wz};
-                            v2={wx+1,wy+height,wz};
-                            v3={wx+1,wy+height,wz+width};
-                            break;
-                        case 4: 
-                            v0={wx,wy+1,wz+height};
-                            v1={wx+width,wy+1,wz+height};
-                            v2={wx+width,wy+1,wz};
-                            v3={wx,wy+1,wz};
-                            break;
-                        case 5: 
-                            v0={wx,wy,wz};
-                            v1={wx+width,wy,wz};
-                            v2={wx+width,wy,wz+height};
-                            v3={wx,wy,wz+height};
-                            break;
-                    }
-                    glm::vec2 uv0(0,0),uv1(width,0),uv2(width,height),uv3(0,height);
-                    if(bt==WATER && face==4){
-                        uv0={v0.x/WATER_TILE_SIZE,v0.z/WATER_TILE_SIZE};
-                        uv1={v1.x/WATER_TILE_SIZE,v1.z/WATER_TILE_SIZE};
-                        uv2={v2.x/WATER_TILE_SIZE,v2.z/WATER_TILE_SIZE};
-                        uv3={v3.x/WATER_TILE_SIZE,v3.z/WATER_TILE_SIZE};
-                    }
-                    pushVertex(buf,v0,uv0,normal);
-                    pushVertex(buf,v1,uv1,normal);
-                    pushVertex(buf,v2,uv2,normal);
-                    pushVertex(buf,v2,uv2,normal);
-                    pushVertex(buf,v3,uv3,normal);
-                    pushVertex(buf,v0,uv0,normal);
-                }
-            }
-        }
-    }
-    for(int i=0;i<NUM_BLOCK_TEXTURES;++i) out.verticesByType[i]=std::move(tempBuffers[i]);
-    return out;
-}
-
-void Chunk::uploadMeshFromData(const MeshData& data) {
-    if(data.chunkX!=chunkX || data.chunkZ!=chunkZ) return;
-    for(int i=0;i<NUM_BLOCK_TEXTURES;++i) verticesByType[i]=data.verticesByType[i];
-    ensureGpuLoaded();
-    for(int i=0;i<NUM_BLOCK_TEXTURES;++i) {
-        glBindVertexArray(VAOs[i]);
-        glBindBuffer(GL_ARRAY_BUFFER,VBOs[i]);
-        if(!verticesByType[i].empty()) {
-            glBufferData(GL_ARRAY_BUFFER,verticesByType[i].size()*sizeof(float),nullptr,GL_STATIC_DRAW);
-            glBufferSubData(GL_ARRAY_BUFFER,0,verticesByType[i].size()*sizeof(float),verticesByType[i].data());
-            int stride=8*sizeof(float);
-            glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,stride,(void*)0);
-            glEnableVertexAttribArray(0);
-            glVertexAttribPointer(1,2,GL_FLOAT,GL_FALSE,stride,(void*)(3*sizeof(float)));
-            glEnableVertexAttribArray(1);
-            glVertexAttribPointer(2,3,GL_FLOAT,GL_FALSE,stride,(void*)(5*sizeof(float)));
-            glEnableVertexAttribArray(2);
-        }
-    }
-    needsUpdate=false;
-    pendingBuild=false;
-}
-
-//Collect transparent faces forglobal sorting. Each tuple: (depth,texIndex,faceIndex,chunkPtr)
-void Chunk::collectTransparentFaces(std::vector<std::tuple<float,int,int,Chunk*>> &out,const glm::vec3* viewDir,const glm::vec3* cameraPos) const {
-    const size_t floatsPerVertex=8;
-    //collect leaves (4),water (6) and cloud (8) as transparent faces forglobal sorting
-    for(int i : {4,6,8}) {
-        if(i<0 || i>=NUM_BLOCK_TEXTURES) continue;
-        const auto &buf=verticesByType[i];
-        if(buf.empty()) continue;
-        size_t totalFloats=buf.size();
-        if(totalFloats % floatsPerVertex!=0) continue;
-        size_t totalVertices=totalFloats/floatsPerVertex;
-        if(totalVertices % 6!=0) continue;
-        size_t faceCount=totalVertices/6;
-        for(size_t f=0;f<faceCount;++f) {
-            glm::vec3 centroid(0.0f);
-            for(int v=0;v<6;++v) {
-                size_t vi=(f*6+v)*floatsPerVertex;
-                float px=buf[vi+0];
-                float py=buf[vi+1];
-                float pz=buf[vi+2];
-                centroid += glm::vec3(px,py,pz);
-            }
-            centroid /= 6.0f;
-            float depth=0.0f;
-            if(viewDir!=nullptr) {
-                if(cameraPos!=nullptr) depth=glm::dot(centroid-*cameraPos,*viewDir);
-                else depth=glm::dot(centroid,*viewDir);
-            } else depth=centroid.z;
-            out.emplace_back(depth,i,static_cast<int>(f),const_cast<Chunk*>(this));
-        }
-    }
-}
-
-// Ƶ͸棨/VAO  faceIndex  6 㣩
-void Chunk::drawTransparentFace(int texIndex,int faceIndex) const {
-    if(texIndex<0 || texIndex>=NUM_BLOCK_TEXTURES) return;
-    if(verticesByType[texIndex].empty()) return;
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D,blockTextures[texIndex]);
-    glBindVertexArray(VAOs[texIndex]);
-    glDrawArrays(GL_TRIANGLES,faceIndex*6,6);
+#include "../include/Chunk.h"
+#include "../include/Common.h"
+#include "../include/Shader.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    //贪婪合并的标记（用单字节枚举而非 uint8_t，避免字符类型别名使编译器每次写入后重新读取数组指针）
+    enum MergeState : uint8_t { NOT_MERGED=0,MERGED=1 };
+
+    //所有 chunk 共用的四边形索引缓冲：第 q 个四边形为 (4q,4q+1,4q+2,4q+2,4q+3,4q)，只增不减
+    GLuint quadIndexBuffer=0;
+    size_t quadIndexCapacity=0;//已写入的四边形数
+
+    //把共享索引缓冲绑定到当前 VAO；不足 quads 个四边形时翻倍扩容（同名缓冲重新分配，已引用它的 VAO 无需重新绑定）
+    void bindQuadIndexBuffer(size_t quads) {
+        if(quadIndexBuffer==0) glGenBuffers(1,&quadIndexBuffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,quadIndexBuffer);
+        if(quads<=quadIndexCapacity) return;
+        size_t capacity=std::max(quads,std::max<size_t>(quadIndexCapacity*2,4096));
+        std::vector<uint32_t> indices(capacity*QUAD_INDICES);
+        static const uint32_t pattern[QUAD_INDICES]={ 0,1,2,2,3,0 };
+        for(size_t q=0;q<capacity;++q)
+            for(int k=0;k<QUAD_INDICES;++k) indices[q*QUAD_INDICES+k]=static_cast<uint32_t>(q*QUAD_VERTICES)+pattern[k];
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER,indices.size()*sizeof(uint32_t),indices.data(),GL_STATIC_DRAW);
+        quadIndexCapacity=capacity;
+    }
+
+    //判断某一扫描行（固定 y 与层号）在给定面方向上是否必然没有可见面：
+    //区段为空，或区段为单一非树叶方块且该面的邻居仍落在同一区段内（同类方块互相遮挡）
+    inline bool isUniformInterior(const SectionFlags* flags,int face,int layer,int y) {
+        const SectionFlags &f=flags[y/SECTION_SIZE];
+        if(f.empty) return true;
+        if(!f.uniform || f.type==LEAVES) return false;
+        switch (face) {
+        case 0: case 3: return layer+1<CHUNK_SIZE;
+        case 1: case 2: return layer-1>=0;
+        case 4: return (y+1)%SECTION_SIZE!=0;
+        default: return y%SECTION_SIZE!=0;
+        }
+    }
+
+    //输出一个合并后的四边形（局部坐标 x,y,z 起，width×height 个方块）到对应纹理组，顶点为打包的 chunk 局部坐标
+    //面方向为模板参数，每个方向的角点布局在编译期选定；四个角点按索引缓冲的 (0,1,2)(2,3,0) 组成两个三角形
+    template<int FACE>
+    void emitQuad(std::vector<PackedVertex>* buffers,int x,int y,int z,int width,int height,BlockType bt) {
+        int texIndex=-1;
+        if(bt==GRASS){
+            if(FACE==4) texIndex=0;
+            else if(FACE==5) texIndex=1;
+            else texIndex=7;
+        } else texIndex=blockTypeToTexIndex(bt);
+        if(texIndex<0) return;
+        auto &buf=buffers[texIndex];
+        glm::ivec3 v0,v1,v2,v3;
+        switch(FACE){
+            case 0: v0={x,y,z+1};
+                v1={x+width,y,z+1};
+                v2={x+width,y+height,z+1};
+                v3={x,y+height,z+1};
+                break;
+            case 1: 
+                v0={x+width,y,z};
+                v1={x,y,z};
+                v2={x,y+height,z};
+                v3={x+width,y+height,z};
+                break;
+            case 2: 
+                v0={x,y,z};
+                v1={x,y,z+width};
+                v2={x,y+height,z+width};
+                v3={x,y+height,z};
+                break;
+            case 3:
+                v0={x+1,y,z+width};
+                v1={x+1,y,z};
+                v2={x+1,y+height,z};
+                v3={x+1,y+height,z+width};
+                break;
+            case 4: 
+                v0={x,y+1,z+height};
+                v1={x+width,y+1,z+height};
+                v2={x+width,y+1,z};
+                v3={x,y+1,z};
+                break;
+            case 5: 
+                v0={x,y,z};
+                v1={x+width,y,z};
+                v2={x+width,y,z+height};
+                v3={x,y,z+height};
+                break;
+        }
+        //水顶面由着色器按世界坐标计算 UV，使相邻 chunk 对齐
+        const bool worldUV=(bt==WATER && FACE==4);
+        buf.push_back(packVertex(v0,FACE,0,0,texIndex,worldUV));
+        buf.push_back(packVertex(v1,FACE,width,0,texIndex,worldUV));
+        buf.push_back(packVertex(v2,FACE,width,height,texIndex,worldUV));
+        buf.push_back(packVertex(v3,FACE,0,height,texIndex,worldUV));
+    }
+
+    //运行期面方向的分派（逐方块参考实现使用）
+    void emitQuad(std::vector<PackedVertex>* buffers,int x,int y,int z,int width,int height,int face,BlockType bt) {
+        switch(face) {
+        case 0: emitQuad<0>(buffers,x,y,z,width,height,bt);break;
+        case 1: emitQuad<1>(buffers,x,y,z,width,height,bt);break;
+        case 2: emitQuad<2>(buffers,x,y,z,width,height,bt);break;
+        case 3: emitQuad<3>(buffers,x,y,z,width,height,bt);break;
+        case 4: emitQuad<4>(buffers,x,y,z,width,height,bt);break;
+        default: emitQuad<5>(buffers,x,y,z,width,height,bt);break;
+        }
+    }
+
+    //面方向 face 构建完毕：记下各纹理组此时的四边形数，即该方向范围的终点（方向须按 0..5 的顺序构建）
+    void markFaceEnd(const std::vector<PackedVertex>* buffers,FaceOffsets* offsets,int face) {
+        for(int i=0;i<NUM_BLOCK_TEXTURES;++i) offsets[i][face+1]=static_cast<uint32_t>(buffers[i].size()/QUAD_VERTICES);
+    }
+
+    //纹理组 4=树叶,6=水,8=云 是透明的，由 World 全局排序后逐面绘制
+    inline bool isTransparentGroup(int texIndex) { return texIndex==4 || texIndex==6 || texIndex==8;}
+
+    //在工作线程算好透明面的质心，上传后 chunk 只保留质心用于排序
+    void packTransparentCentroids(MeshData &out) {
+        for(int i=0;i<NUM_BLOCK_TEXTURES;++i) {
+            if(!isTransparentGroup(i)) continue;
+            const std::vector<PackedVertex> &vertices=out.verticesByType[i];
+            std::vector<uint32_t> &centroids=out.transparentCentroids[i];
+            centroids.resize(vertices.size()/QUAD_VERTICES);
+            for(size_t f=0;f<centroids.size();++f) centroids[f]=packCentroid(&vertices[f*QUAD_VERTICES]);
+        }
+    }
+
+    //==================== 位掩码网格构建 ====================
+    //一行 CHUNK_SIZE 格的位掩码，第 i 位对应行内坐标 i
+    typedef uint64_t RowMask;
+
+    inline RowMask lowBits(int n) { return n>=64 ? ~RowMask(0) : ((RowMask(1)<<n)-1);}
+    inline int lowestSetBit(RowMask v) { return highestSetBit(v & (~v+1));}
+
+    //一行（固定 y,z）方块的分类，x=-1 与 x=CHUNK_SIZE 两格（邻居边界）放在 edge 中
+    struct RowClasses {
+        RowMask filled=0;//非空气
+        RowMask water=0;
+        RowMask leaves=0;
+        uint8_t edge=0;//第 0/1 位：x=-1 非空气/为水；第 2/3 位：x=CHUNK_SIZE 非空气/为水
+    };
+
+    //与 isFaceVisible 相同的规则：树叶总是可见；水只在邻居为空气时可见；其他方块在邻居为空气或水时可见
+    inline RowMask visibleFaces(const RowClasses &self,RowMask nbFilled,RowMask nbWater) {
+        RowMask other=self.filled & ~self.water & ~self.leaves;
+        return self.leaves | (self.water & ~nbFilled) | (other & ~(nbFilled & ~nbWater));
+    }
+
+    //在一个切面上做贪婪合并：mask[r] 为第 r 行尚未合并的可见面，按行、行内按位从低到高取起点，
+    //先沿行内扩展同类方块，再逐行向上扩展，与逐方块扫描的合并顺序和结果一致
+    template<typename TypeAt,typename Emit>
+    void greedyPlane(RowMask* mask,int rows,TypeAt typeAt,Emit emit) {
+        for(int r=0;r<rows;++r) {
+            while(mask[r]) {
+                int d1=lowestSetBit(mask[r]);
+                BlockType bt=typeAt(d1,r);
+                int width=1;
+                while(d1+width<CHUNK_SIZE && ((mask[r]>>(d1+width))&1) && typeAt(d1+width,r)==bt) ++width;
+                const RowMask run=lowBits(width)<<d1;
+                int height=1;
+                for(;r+height<rows;++height) {
+                    if((mask[r+height]&run)!=run) break;
+                    bool same=true;
+                    for(int w=0;w<width && same;++w) same=typeAt(d1+w,r+height)==bt;
+                    if(!same) break;
+                }
+                for(int h=0;h<height;++h) mask[r+h]&=~run;
+                emit(d1,r,width,height,bt);
+            }
+        }
+    }
+
+    //一个面方向：法线 (NX,NY,NZ)，贪婪合并的切面轴 SLICE、行轴 ROW、行内轴 COL（0=x,1=y,2=z）
+    //每个方向各实例化一份网格构建循环，邻居选取、坐标换算和顶点布局都在编译期确定
+    template<int NX,int NY,int NZ,int SLICE,int ROW,int COL>
+    struct FaceDir {
+        //面编号与 isFaceVisible/emitQuad 一致：0=+Z,1=-Z,2=-X,3=+X,4=+Y,5=-Y
+        static constexpr int FACE=NZ>0 ? 0 : NZ<0 ? 1 : NX<0 ? 2 : NX>0 ? 3 : NY>0 ? 4 : 5;
+        static constexpr int NORMAL_X=NX,NORMAL_Y=NY,NORMAL_Z=NZ;
+        static constexpr int SLICE_AXIS=SLICE,ROW_AXIS=ROW,COL_AXIS=COL;
+        //(切面,行,行内) -> (x,y,z)
+        static void toXYZ(int s,int r,int c,int &x,int &y,int &z) {
+            int v[3];
+            v[SLICE]=s;v[ROW]=r;v[COL]=c;
+            x=v[0];y=v[1];z=v[2];
+        }
+    };
+    //轴排列与逐方块扫描相同：±Z 切面 z、行 y、行内 x；±X 切面 x、行 y、行内 z；±Y 切面 y、行 z、行内 x
+    typedef FaceDir< 0, 0, 1,2,1,0> FacePosZ;
+    typedef FaceDir< 0, 0,-1,2,1,0> FaceNegZ;
+    typedef FaceDir<-1, 0, 0,0,1,2> FaceNegX;
+    typedef FaceDir< 1, 0, 0,0,1,2> FacePosX;
+    typedef FaceDir< 0, 1, 0,1,2,0> FacePosY;
+    typedef FaceDir< 0,-1, 0,1,2,0> FaceNegY;
+
+    //网格构建的临时缓冲：各纹理组的顶点、行分类、切面掩码与逐方块实现的合并标记
+    //每个线程一份（threadMeshScratch），容量在多次构建之间保留，稳定后构建过程不再分配内存；结果按实际大小一次拷出
+    struct MeshScratch {
+        std::vector<PackedVertex> vertices[NUM_BLOCK_TEXTURES];
+        std::vector<RowClasses> rows;
+        std::vector<RowMask> plane;
+        DenseVolume<MergeState> merged;
+
+        void clearVertices() { for(auto &v : vertices) v.clear();}
+        //顶点按实际大小拷入 out（每个非空纹理组一次分配），之后只随上传条目移动、上传后释放，不再拷贝
+        void copyVerticesTo(MeshData &out) const {
+            for(int i=0;i<NUM_BLOCK_TEXTURES;++i) out.verticesByType[i].assign(vertices[i].begin(),vertices[i].end());
+        }
+    };
+
+    MeshScratch& threadMeshScratch() {
+        thread_local MeshScratch scratch;
+        return scratch;
+    }
+
+    //一次位掩码网格构建：构造时把快照分类成行掩码，meshDirection<Dir> 输出一个面方向的全部四边形
+    class RowMesher {
+    public:
+        RowMesher(const MeshSnapshot &snapshot,MeshScratch &scratch);
+        template<typename Dir> void meshDirection();
+
+    private:
+        //分类行：y 取 [bottom-1,top]（含上下邻居层），z 取 [-1,CHUNK_SIZE]（含前后邻居边界）
+        RowClasses& rowAt(int y,int z) { return rows[(size_t)(y-bottom+1)*(CHUNK_SIZE+2)+z+1];}
+        //各轴在本次构建中的起点与长度（只有 y 轴被裁剪到内容范围）
+        int axisBegin(int axis) const { return axis==1 ? bottom : 0;}
+        int axisCount(int axis) const { return axis==1 ? layers : CHUNK_SIZE;}
+
+        const PaddedBlocks &blocks;
+        std::vector<PackedVertex>* buffers;
+        int bottom,top,layers;
+        std::vector<RowClasses> &rows;
+        std::vector<RowMask> &plane;//当前方向的可见面，plane[切面*行数+行] 的第 (行内坐标) 位
+    };
+
+    RowMesher::RowMesher(const MeshSnapshot &snapshot,MeshScratch &scratch)
+        : blocks(snapshot.blocks),buffers(scratch.vertices),
+          bottom(snapshot.blocks.getBaseY()),top(snapshot.meshTop),layers(std::max(0,top-bottom)),
+          rows(scratch.rows),plane(scratch.plane) {
+        if(layers==0) return;
+        const RowMask full=lowBits(CHUNK_SIZE);
+        //缓冲来自上一次构建，按本次大小重置（容量足够时不分配）
+        rows.assign((size_t)(layers+2)*(CHUNK_SIZE+2),RowClasses());
+        plane.assign((size_t)CHUNK_SIZE*layers,0);
+        for(int y=bottom-1;y<=top;++y) {
+            if(!blocks.containsY(y)) continue;
+            const SectionFlags &flags=snapshot.sectionFlags[y/SECTION_SIZE];
+            for(int z=-1;z<=CHUNK_SIZE;++z) {
+                RowClasses &r=rowAt(y,z);
+                const BlockType* p=&blocks.at(-1,y,z);
+                if(p[0]!=AIR) r.edge|=(p[0]==WATER) ? 3 : 1;
+                if(p[CHUNK_SIZE+1]!=AIR) r.edge|=(p[CHUNK_SIZE+1]==WATER) ? 12 : 4;
+                //本 chunk 的均匀区段（含空区段）整行同类，无需逐格读取
+                if(z>=0 && z<CHUNK_SIZE && flags.uniform) {
+                    if(flags.type!=AIR) r.filled=full;
+                    if(flags.type==WATER) r.water=full;
+                    else if(flags.type==LEAVES) r.leaves=full;
+                    continue;
+                }
+                for(int x=0;x<CHUNK_SIZE;++x) {
+                    BlockType b=p[x+1];
+                    if(b==AIR) continue;
+                    RowMask bit=RowMask(1)<<x;
+                    r.filled|=bit;
+                    if(b==WATER) r.water|=bit;
+                    else if(b==LEAVES) r.leaves|=bit;
+                }
+            }
+        }
+    }
+
+    template<typename Dir>
+    void RowMesher::meshDirection() {
+        if(layers==0) return;
+        const RowMask full=lowBits(CHUNK_SIZE);
+        const RowMask highBit=RowMask(1)<<(CHUNK_SIZE-1);
+        const int sliceBegin=axisBegin(Dir::SLICE_AXIS),slices=axisCount(Dir::SLICE_AXIS);
+        const int rowBegin=axisBegin(Dir::ROW_AXIS),rowCount=axisCount(Dir::ROW_AXIS);
+
+        //可见面直接写成本方向的切面布局；行内轴为 x 时整行写入，为 z 时按位转置
+        std::fill(plane.begin(),plane.end(),0);
+        for(int y=bottom;y<top;++y) {
+            for(int z=0;z<CHUNK_SIZE;++z) {
+                const RowClasses &c=rowAt(y,z);
+                if(!c.filled) continue;
+                RowMask m;
+                if(Dir::NORMAL_X<0) {
+                    //±X 的邻居是同一行错开一位，行两端补上邻居边界
+                    m=visibleFaces(c,((c.filled<<1)&full)|((c.edge&1) ? 1 : 0),((c.water<<1)&full)|((c.edge&2) ? 1 : 0));
+                } else if(Dir::NORMAL_X>0) {
+                    m=visibleFaces(c,(c.filled>>1)|((c.edge&4) ? highBit : 0),(c.water>>1)|((c.edge&8) ? highBit : 0));
+                } else {
+                    const RowClasses &n=rowAt(y+Dir::NORMAL_Y,z+Dir::NORMAL_Z);
+                    m=visibleFaces(c,n.filled,n.water);
+                }
+                int v[3]={0,y-bottom,z};
+                if(Dir::COL_AXIS==0) {
+                    plane[(size_t)v[Dir::SLICE_AXIS]*rowCount+v[Dir::ROW_AXIS]]=m;
+                    continue;
+                }
+                for(;m;m&=m-1) {
+                    v[0]=lowestSetBit(m);
+                    plane[(size_t)v[Dir::SLICE_AXIS]*rowCount+v[Dir::ROW_AXIS]]|=RowMask(1)<<v[Dir::COL_AXIS];
+                }
+            }
+        }
+
+        //与逐方块扫描相同的切面/行/行内顺序合并并输出
+        for(int s=0;s<slices;++s) {
+            const int slice=sliceBegin+s;
+            greedyPlane(&plane[(size_t)s*rowCount],rowCount,
+                [&](int d1,int r) {
+                    int x,y,z;
+                    Dir::toXYZ(slice,rowBegin+r,d1,x,y,z);
+                    return blocks.at(x,y,z);
+                },
+                [&](int d1,int r,int w,int h,BlockType bt) {
+                    int x,y,z;
+                    Dir::toXYZ(slice,rowBegin+r,d1,x,y,z);
+                    emitQuad<Dir::FACE>(buffers,x,y,z,w,h,bt);
+                });
+        }
+    }
+}
+
+//构造函数：方块数据默认为 AIR，VAO/VBO 延迟创建
+Chunk::Chunk(int x,int z) : sections(getWorldSections()),chunkX(x),chunkZ(z),needsUpdate(true),pendingBuild(false),gpuLoaded(false) {
+    //各区段默认构造为单一 AIR，无需逐方块初始化
+
+    // 将 GL 资源创建延迟到上传时，避免大量创建 chunk 时卡顿
+    // glGenVertexArrays(NUM_BLOCK_TEXTURES, VAOs);
+    // glGenBuffers(NUM_BLOCK_TEXTURES, VBOs);
+}
+
+void Chunk::reset(int x,int z) {
+    {
+        std::lock_guard<std::mutex> lk(storageMutex);
+        for(ChunkSection &sec : sections) {
+            sec.blocks.fill(AIR);
+            sec.nonAirCount=0;
+            sec.masks.reset();
+        }
+        std::memset(columnTop,0,sizeof(columnTop));
+        std::memset(solidTop,0,sizeof(solidTop));
+    }
+    chunkX=x;
+    chunkZ=z;
+    for(int i=0;i<NUM_BLOCK_TEXTURES;++i) transparentCentroids[i].clear();
+    std::memset(faceOffsets,0,sizeof(faceOffsets));
+    meshBottom=meshTop=0;
+    needsUpdate=true;
+    pendingBuild=false;
+    meshMissingSides=0;
+    meshUploaded=false;
+    jobDeferred=false;
+    unseenEdit=false;
+    setState(CHUNK_QUEUED);
+}
+
+//析构：释放 OpenGL 资源
+Chunk::~Chunk() {
+    if(gpuLoaded) {
+        glDeleteVertexArrays(NUM_BLOCK_TEXTURES,VAOs);
+        glDeleteBuffers(NUM_BLOCK_TEXTURES,VBOs);
+    }
+}
+
+// 确保 GPU 资源存在（必须在 GL 线程调用）
+void Chunk::ensureGpuLoaded() {
+    if(gpuLoaded) return;
+    glGenVertexArrays(NUM_BLOCK_TEXTURES,VAOs);
+    glGenBuffers(NUM_BLOCK_TEXTURES,VBOs);
+    gpuLoaded=true;
+}
+
+//获取方块类型（越界返回 AIR）
+BlockType Chunk::getBlock(int x,int y,int z) const {
+    if(x<0 || x>=CHUNK_SIZE || y<0 || y>=getWorldHeight() || z<0 || z>=CHUNK_SIZE) return AIR;
+    std::lock_guard<std::mutex> lk(storageMutex);
+    const ChunkSection &sec=sections[ChunkLayout::sectionOf(y)];
+    if(sec.isEmpty()) return AIR;
+    return sec.blocks.get(PalettedContainer::indexOf(x,ChunkLayout::localY(y),z));
+}
+
+BlockType Chunk::getBlockOnMainThread(int x,int y,int z) const {
+    if(!hasTerrain()) return getBlock(x,y,z);//工作线程可能仍在写入
+    if(x<0 || x>=CHUNK_SIZE || y<0 || y>=getWorldHeight() || z<0 || z>=CHUNK_SIZE) return AIR;
+    const ChunkSection &sec=sections[ChunkLayout::sectionOf(y)];
+    if(sec.isEmpty()) return AIR;
+    return sec.blocks.get(PalettedContainer::indexOf(x,ChunkLayout::localY(y),z));
+}
+
+//设置方块并标记需要重建网格
+void Chunk::setBlock(int x,int y,int z,BlockType type) {
+    if(x<0 || x>=CHUNK_SIZE || y<0 || y>=getWorldHeight() || z<0 || z>=CHUNK_SIZE) return;
+    {
+        std::lock_guard<std::mutex> lk(storageMutex);
+        ChunkSection &sec=sections[ChunkLayout::sectionOf(y)];
+        int idx=PalettedContainer::indexOf(x,ChunkLayout::localY(y),z);
+        BlockType old=sec.blocks.get(idx);
+        sec.blocks.set(idx,type);
+        if(old==AIR && type!=AIR) sec.nonAirCount++;
+        else if(old!=AIR && type==AIR) sec.nonAirCount--;
+        //区段被挖空后回收压缩数据
+        if(sec.nonAirCount==0) sec.blocks.fill(AIR);
+        updateColumn(x,y,z,old,type);
+        ++editVersion;
+    }
+    needsUpdate=true;
+}
+
+void Chunk::markEdited() {
+    {
+        std::lock_guard<std::mutex> lk(storageMutex);
+        ++editVersion;
+    }
+    needsUpdate=true;
+}
+
+//解包有内容的区段到快照（最低到最高非空区段），四周边界先填 WATER 并标记为缺失，由 World 拷入已生成的邻居
+void Chunk::copyForMeshing(MeshSnapshot &out) const {
+    std::lock_guard<std::mutex> lk(storageMutex);
+    out.chunkX=chunkX;
+    out.chunkZ=chunkZ;
+    out.missingSides=0xF;
+    out.editVersion=editVersion;
+    int count=static_cast<int>(sections.size());
+    out.sectionFlags.resize(count);
+    int lo=count,hi=-1;
+    for(int s=0;s<count;++s) {
+        const ChunkSection &sec=sections[s];
+        out.sectionFlags[s].empty=sec.isEmpty();
+        out.sectionFlags[s].uniform=sec.isUniform();
+        out.sectionFlags[s].type=sec.uniformType();
+        if(sec.isEmpty()) continue;
+        lo=std::min(lo,s);
+        hi=std::max(hi,s);
+    }
+    int top=0;
+    for(int x=0;x<CHUNK_SIZE;++x)
+        for(int z=0;z<CHUNK_SIZE;++z) top=std::max(top,(int)columnTop[x][z]);
+    out.meshTop=top;
+    if(hi<0) {
+        //没有方块，不会产生面，也不需要邻居边界
+        out.blocks.resize(0,0,AIR);
+        out.missingSides=0;
+        return;
+    }
+    //整体先填 WATER（缺失邻居的约定值），内部再被区段数据覆盖
+    PaddedBlocks &blocks=out.blocks;
+    blocks.resize(lo*SECTION_SIZE,(hi+1)*SECTION_SIZE,WATER);
+    BlockType unpacked[PalettedContainer::VOLUME];
+    for(int s=lo;s<=hi;++s) {
+        const ChunkSection &sec=sections[s];
+        const int y0=s*SECTION_SIZE;
+        const bool uniform=sec.isEmpty() || sec.isUniform();
+        const BlockType fillType=sec.isEmpty() ? AIR : sec.uniformType();
+        if(!uniform) sec.blocks.unpack(unpacked);
+        //区段内按 (y,z,x) 存放，逐行拷入带边界的行
+        for(int ly=0;ly<SECTION_SIZE;++ly)
+            for(int z=0;z<CHUNK_SIZE;++z) {
+                BlockType* dst=&blocks.at(0,y0+ly,z);
+                if(uniform) std::fill(dst,dst+CHUNK_SIZE,fillType);
+                else std::memcpy(dst,unpacked+ChunkLayout::indexOf(0,ly,z),CHUNK_SIZE*sizeof(BlockType));
+            }
+    }
+}
+
+void Chunk::copyBorderTo(MeshSnapshot &out,int side) const {
+    PaddedBlocks &blocks=out.blocks;
+    if(blocks.getTopY()<=blocks.getBaseY()) return;
+    const int y0=blocks.getBaseY(),y1=blocks.getTopY()-1;
+    //(CHUNK_SIZE+2) 宽的行与层跨度
+    const int strideZ=PaddedBlocks::WIDTH,strideY=PaddedBlocks::WIDTH*PaddedBlocks::WIDTH;
+    const int last=CHUNK_SIZE-1;
+    switch (side) {
+    case 0: readRegion(0,last,y0,y1,0,0,&blocks.at(0,y0,CHUNK_SIZE),strideY,strideZ);break;//+Z 邻居的 z=0 行
+    case 1: readRegion(0,last,y0,y1,last,last,&blocks.at(0,y0,-1),strideY,strideZ);break;//-Z 邻居的 z=last 行
+    //x 方向只取一列：把 z 步长当作行步长
+    case 2: readRegion(last,last,y0,y1,0,last,&blocks.at(-1,y0,0),strideY,strideZ);break;//-X 邻居的 x=last 列
+    default: readRegion(0,0,y0,y1,0,last,&blocks.at(CHUNK_SIZE,y0,0),strideY,strideZ);break;//+X 邻居的 x=0 列
+    }
+    out.missingSides&=~(1<<side);
+}
+
+//将稠密数组按区段打包，每个区段自动选择最小位宽；混合区段同时建立列掩码
+void Chunk::storeBlocks(const DenseBlocks &src,int lowY,int highY) {
+    //列高度图先在局部构建，最后整体替换
+    uint16_t top[CHUNK_SIZE][CHUNK_SIZE]={};
+    uint16_t solid[CHUNK_SIZE][CHUNK_SIZE]={};
+    for(int s=0;s<static_cast<int>(sections.size());++s) {
+        int baseY=s*SECTION_SIZE;
+        if(baseY+SECTION_SIZE<=lowY) {
+            for(int x=0;x<CHUNK_SIZE;++x)
+                for(int z=0;z<CHUNK_SIZE;++z) {
+                    top[x][z]=static_cast<uint16_t>(baseY+SECTION_SIZE);
+                    solid[x][z]=static_cast<uint16_t>(baseY+SECTION_SIZE);
+                }
+            std::lock_guard<std::mutex> lk(storageMutex);
+            sections[s].blocks.fill(STONE);
+            sections[s].nonAirCount=PalettedContainer::VOLUME;
+            sections[s].masks.reset();
+            continue;
+        }
+        if(baseY>=highY) {
+            std::lock_guard<std::mutex> lk(storageMutex);
+            sections[s].blocks.fill(AIR);
+            sections[s].nonAirCount=0;
+            sections[s].masks.reset();
+            continue;
+        }
+        const BlockType* cells=src.layer(baseY);
+        std::unique_ptr<SectionColumnMasks> masks(new SectionColumnMasks());
+        int nonAir=0;
+        for(int y=0;y<SECTION_SIZE;++y)
+            for(int z=0;z<CHUNK_SIZE;++z)
+                for(int x=0;x<CHUNK_SIZE;++x) {
+                    BlockType t=cells[PalettedContainer::indexOf(x,y,z)];
+                    if(t==AIR) continue;
+                    ++nonAir;
+                    uint16_t bit=static_cast<uint16_t>(1u<<y);
+                    int ci=z*CHUNK_SIZE+x;
+                    if(isSolidBlock(t)) {
+                        masks->solid[ci] |= bit;
+                        solid[x][z]=static_cast<uint16_t>(baseY+y+1);
+                    }
+                    if(isOpaqueBlock(t)) masks->opaque[ci] |= bit;
+                    if(isFluidBlock(t)) masks->fluid[ci] |= bit;
+                    top[x][z]=static_cast<uint16_t>(baseY+y+1);
+                }
+        PalettedContainer packed;
+        packed.load(cells);
+        if(packed.isUniform()) masks.reset();
+        std::lock_guard<std::mutex> lk(storageMutex);
+        sections[s].blocks=std::move(packed);
+        sections[s].nonAirCount=nonAir;
+        sections[s].masks=std::move(masks);
+    }
+    std::lock_guard<std::mutex> lk(storageMutex);
+    std::memcpy(columnTop,top,sizeof(columnTop));
+    std::memcpy(solidTop,solid,sizeof(solidTop));
+}
+
+void Chunk::updateColumn(int x,int y,int z,BlockType old,BlockType type) {
+    ChunkSection &sec=sections[ChunkLayout::sectionOf(y)];
+    int ly=ChunkLayout::localY(y);
+    if(sec.isUniform()) {
+        sec.masks.reset();
+    } else {
+        if(!sec.masks) {
+            //区段刚由均匀变为混合：其余格子都是原来的均匀类型 old
+            sec.masks.reset(new SectionColumnMasks());
+            std::fill(sec.masks->solid,sec.masks->solid+CHUNK_SIZE*CHUNK_SIZE,isSolidBlock(old) ? 0xFFFF : 0);
+            std::fill(sec.masks->opaque,sec.masks->opaque+CHUNK_SIZE*CHUNK_SIZE,isOpaqueBlock(old) ? 0xFFFF : 0);
+            std::fill(sec.masks->fluid,sec.masks->fluid+CHUNK_SIZE*CHUNK_SIZE,isFluidBlock(old) ? 0xFFFF : 0);
+        }
+        int ci=z*CHUNK_SIZE+x;
+        uint16_t bit=static_cast<uint16_t>(1u<<ly);
+        sec.masks->solid[ci]=isSolidBlock(type) ? (sec.masks->solid[ci]|bit) : (sec.masks->solid[ci]&~bit);
+        sec.masks->opaque[ci]=isOpaqueBlock(type) ? (sec.masks->opaque[ci]|bit) : (sec.masks->opaque[ci]&~bit);
+        sec.masks->fluid[ci]=isFluidBlock(type) ? (sec.masks->fluid[ci]|bit) : (sec.masks->fluid[ci]&~bit);
+    }
+
+    if(isSolidBlock(type)) {
+        if(y+1>solidTop[x][z]) solidTop[x][z]=static_cast<uint16_t>(y+1);
+    } else if(y+1==solidTop[x][z]) {
+        //移除了最高实心方块：按区段掩码向下查找
+        int top=0;
+        for(int s=y/SECTION_SIZE;s>=0;--s) {
+            uint16_t bits=sections[s].solidBits(x,z);
+            if(s==y/SECTION_SIZE) bits &= static_cast<uint16_t>((1u<<ly)-1u);
+            if(bits) {
+                top=s*SECTION_SIZE+highestSetBit(bits)+1;
+                break;
+            }
+        }
+        solidTop[x][z]=static_cast<uint16_t>(top);
+    }
+
+    if(type!=AIR) {
+        if(y+1>columnTop[x][z]) columnTop[x][z]=static_cast<uint16_t>(y+1);
+        return;
+    }
+    if(y+1!=columnTop[x][z]) return;
+    //移除了列顶方块：向下找到新的最高非空气方块（整段为空的区段直接跳过）
+    int top=y;
+    while (top>0) {
+        const ChunkSection &below=sections[(top-1)/SECTION_SIZE];
+        if(below.isEmpty()) {
+            top=(top-1)/SECTION_SIZE*SECTION_SIZE;
+            continue;
+        }
+        if(below.blocks.get(PalettedContainer::indexOf(x,(top-1)%SECTION_SIZE,z))!=AIR) break;
+        --top;
+    }
+    columnTop[x][z]=static_cast<uint16_t>(top);
+}
+
+ColumnMask Chunk::columnBits(int x,int z,int baseY,int kind) const {
+    ColumnMask out=0;
+    int first=baseY>=0 ? baseY/SECTION_SIZE : -((-baseY+SECTION_SIZE-1)/SECTION_SIZE);
+    for(int s=std::max(first,0);s<=first+64/SECTION_SIZE && s<static_cast<int>(sections.size());++s) {
+        const ChunkSection &sec=sections[s];
+        ColumnMask bits=(kind==0) ? sec.solidBits(x,z) : (kind==1) ? sec.opaqueBits(x,z) : sec.fluidBits(x,z);
+        if(bits==0) continue;
+        int shift=s*SECTION_SIZE-baseY;
+        if(shift>=64) break;
+        out |= (shift>=0) ? (bits<<shift) : (bits>>(-shift));
+    }
+    return out;
+}
+
+int Chunk::getTopSolidY(int x,int z) const {
+    std::lock_guard<std::mutex> lk(storageMutex);
+    return solidTop[x][z]-1;
+}
+
+ColumnMask Chunk::getSolidMask(int x,int z,int baseY) const {
+    std::lock_guard<std::mutex> lk(storageMutex);
+    return columnBits(x,z,baseY,0);
+}
+
+ColumnMask Chunk::getOpaqueMask(int x,int z,int baseY) const {
+    std::lock_guard<std::mutex> lk(storageMutex);
+    return columnBits(x,z,baseY,1);
+}
+
+ColumnMask Chunk::getFluidMask(int x,int z,int baseY) const {
+    std::lock_guard<std::mutex> lk(storageMutex);
+    return columnBits(x,z,baseY,2);
+}
+
+void Chunk::readRegion(int x0,int x1,int y0,int y1,int z0,int z1,BlockType* out,int strideY,int strideZ) const {
+    std::lock_guard<std::mutex> lk(storageMutex);
+    for(int y=y0;y<=y1;++y) {
+        const ChunkSection &sec=sections[ChunkLayout::sectionOf(y)];
+        int ly=ChunkLayout::localY(y);
+        BlockType* row=out+(y-y0)*strideY;
+        for(int z=z0;z<=z1;++z) {
+            BlockType* dst=row+(z-z0)*strideZ;
+            if(sec.isUniform()) {
+                std::fill(dst,dst+(x1-x0+1),sec.uniformType());
+                continue;
+            }
+            for(int x=x0;x<=x1;++x) dst[x-x0]=sec.blocks.get(PalettedContainer::indexOf(x,ly,z));
+        }
+    }
+}
+
+void Chunk::getContentRange(int &bottom,int &top) const {
+    std::lock_guard<std::mutex> lk(storageMutex);
+    bottom=0;
+    top=0;
+    int count=static_cast<int>(sections.size());
+    for(int s=count-1;s>=0;--s) {
+        if(sections[s].isEmpty()) continue;
+        top=(s+1)*SECTION_SIZE;
+        break;
+    }
+    for(int s=0;s<count;++s) {
+        if(sections[s].isEmpty()) continue;
+        bottom=s*SECTION_SIZE;
+        break;
+    }
+}
+
+size_t Chunk::columnMemoryBytes() const {
+    std::lock_guard<std::mutex> lk(storageMutex);
+    size_t total=sizeof(columnTop)+sizeof(solidTop);
+    for(const ChunkSection &sec : sections)
+        if(sec.masks) total += sizeof(SectionColumnMasks);
+    return total;
+}
+
+bool Chunk::isSectionEmpty(int section) const {
+    std::lock_guard<std::mutex> lk(storageMutex);
+    return sections[section].isEmpty();
+}
+
+bool Chunk::isSectionUniform(int section,BlockType* type) const {
+    std::lock_guard<std::mutex> lk(storageMutex);
+    const ChunkSection &sec=sections[section];
+    if(type) *type=sec.uniformType();
+    return sec.isUniform();
+}
+
+size_t Chunk::blockMemoryBytes() const {
+    std::lock_guard<std::mutex> lk(storageMutex);
+    size_t total=0;
+    for(const ChunkSection &sec : sections) total += sec.blocks.memoryBytes();
+    return total;
+}
+
+int Chunk::sectionBitsPerEntry(int section) const {
+    std::lock_guard<std::mutex> lk(storageMutex);
+    return sections[section].blocks.bitsPerEntry();
+}
+
+//根据方块类型返回基础颜色（仅用于调试/替代贴图时）
+glm::vec3 Chunk::getBlockColor(BlockType type) {
+    switch (type) {
+        case GRASS: return glm::vec3(0.4f,0.8f,0.3f);
+        case DIRT:  return glm::vec3(0.6f,0.4f,0.2f);
+        case STONE: return glm::vec3(0.5f);
+        case WOOD:  return glm::vec3(0.6f,0.3f,0.1f);
+        case LEAVES:return glm::vec3(0.2f,0.6f,0.2f);
+        case CLOUD: return glm::vec3(1.0f,1.0f,1.0f);
+        case SAND:  return glm::vec3(0.9f,0.9f,0.6f);
+        case WATER: return glm::vec3(0.2f,0.4f,0.8f);
+        default:    return glm::vec3(1.0f);
+    }
+}
+
+//生成地形：第一遍计算高度图，第二遍按高度和生物群系填充方块
+bool Chunk::generateTerrain(uint32_t epoch) {
+    //在稠密数组中生成（只覆盖 [lowY,highY)），最后一次性打包进压缩存储
+    DenseBlocks blocks;
+    const int worldHeight=getWorldHeight();
+
+    //第一遍：为当前 chunk 计算高度图
+    int heightMap[CHUNK_SIZE][CHUNK_SIZE];
+    for(int cx=0;cx<CHUNK_SIZE;++cx) {
+        for(int cz=0;cz<CHUNK_SIZE;++cz) {
+            float worldX=static_cast<float>(chunkX*CHUNK_SIZE+cx);
+            float worldZ=static_cast<float>(chunkZ*CHUNK_SIZE+cz);
+            float h=calculateTerrainHeight(worldX,worldZ);
+            int terrainHeight=static_cast<int>(h);
+            //河谷雕刻
+            float riverNoise=octavePerlin(worldX,worldZ,3,0.5f,2.0f,RIVER_FREQ);
+            float riverBand=std::abs(riverNoise);
+            if(riverBand<RIVER_WIDTH) {
+                float t=1.0f-(riverBand/RIVER_WIDTH);
+                int carve=static_cast<int>(std::round(t*RIVER_DEPTH));
+                if(terrainHeight-carve>WATER_LEVEL-5)
+                    terrainHeight=std::max(WATER_LEVEL,terrainHeight-carve);
+				else terrainHeight =  terrainHeight - carve;
+            }
+            heightMap[cx][cz]=terrainHeight;
+        }
+    }
+
+    //均匀区段快速路径：所有列都为 STONE 的底部区段、高于全部地表内容（地形/水/树）的顶部区段
+    //不逐方块写入，打包时直接整段填充。y=WATER_LEVEL-1 层会被河岸处理改写，必须保留在逐方块范围内
+    const int TREE_HEADROOM=11;//树干最高 8 格+叶冠 3 格
+    int minStoneTop=worldHeight,maxSurface=0;
+    for(int cx=0;cx<CHUNK_SIZE;++cx) {
+        for(int cz=0;cz<CHUNK_SIZE;++cz) {
+            minStoneTop=std::min(minStoneTop,heightMap[cx][cz]-5);
+            maxSurface=std::max(maxSurface,heightMap[cx][cz]);
+        }
+    }
+    int lowY=std::max(0,std::min(minStoneTop,WATER_LEVEL-1))/SECTION_SIZE*SECTION_SIZE;
+    int contentTop=std::max(maxSurface+TREE_HEADROOM,WATER_LEVEL);
+    int highY=std::min(worldHeight,(contentTop+SECTION_SIZE-1)/SECTION_SIZE*SECTION_SIZE);
+    if(isJobCancelled(epoch)) return false;
+    blocks.resize(lowY,highY,AIR);
+
+    //第二遍：根据高度图与生物群系垂直填充方块
+	int WATERH = WATER_LEVEL-1;
+    BlockType blocksCache[CHUNK_SIZE][CHUNK_SIZE],blocksCache2[CHUNK_SIZE][CHUNK_SIZE];
+    for(int cx=0;cx<CHUNK_SIZE;++cx) {
+        for(int cz=0;cz<CHUNK_SIZE;++cz) {
+            float worldX=static_cast<float>(chunkX*CHUNK_SIZE+cx);
+            float worldZ=static_cast<float>(chunkZ*CHUNK_SIZE+cz);
+            int terrainHeight=heightMap[cx][cz];
+
+            float riverNoise=octavePerlin(worldX,worldZ,3,0.5f,2.0f,RIVER_FREQ);
+            float riverBand=std::abs(riverNoise);
+            bool isRiver=(riverBand<RIVER_WIDTH);
+
+            BiomeType biome=getBiome(worldX,worldZ,terrainHeight);
+
+            for(int y=lowY;y<highY;++y) {
+                if(y<terrainHeight-5) {
+                    blocks.at(cx,y,cz)=STONE;
+                } else if(y<terrainHeight-1) {
+                    blocks.at(cx,y,cz)=DIRT;
+                } else if(y<terrainHeight) {
+                    if(isRiver && terrainHeight<=WATER_LEVEL+2) {
+                        blocks.at(cx,y,cz)=SAND;
+                    } else if(biome==BIOME_BEACH || biome==BIOME_DESERT || biome==BIOME_OCEAN) {
+                        blocks.at(cx,y,cz)=SAND;
+                    } else if(biome==BIOME_SNOW || biome==BIOME_MOUNTAINS) {
+                        blocks.at(cx,y,cz)=STONE;
+                    } else {
+                        blocks.at(cx,y,cz)=GRASS;
+                    }
+                } else {
+                    blocks.at(cx,y,cz)=AIR;
+                }
+            }
+
+            //若地形低于水面，则填充水直到水位
+            if (terrainHeight < WATER_LEVEL) {
+                for (int y = terrainHeight; y < WATER_LEVEL && y < worldHeight; ++y) {
+                    blocks.at(cx,y,cz) = WATER;
+                }
+                blocksCache[cx][cz] = WATER;
+            }else{
+                blocksCache[cx][cz]=blocks.at(cx,WATERH,cz);
+            }
+        }
+    }
+
+    if(isJobCancelled(epoch)) return false;
+    //河流侵蚀与沉积
+    int dx[8]={-1,-1,-1,0,0,1,1,1};
+    int dz[8]={-1,0,1,-1,1,-1,0,1};
+    memcpy(blocksCache2, blocksCache, sizeof(blocksCache));
+    for(int cx=0;cx<CHUNK_SIZE;++cx) {
+        for(int cz=0;cz<CHUNK_SIZE;++cz) {
+            if (blocksCache2[cx][cz]!=WATER) {
+                for(int dir=0;dir<8;++dir) {
+                    int nx=cx+dx[dir];
+                    int nz=cz+dz[dir];
+                    if(nx>=0&&nx<CHUNK_SIZE&&nz>=0&&nz<CHUNK_SIZE&&blocksCache[nx][nz]==WATER) {
+						blocksCache2[cx][cz]=WATER;
+						break;
+                    }
+				}
+            }
+        }
+    }
+    for(int cx=0;cx<CHUNK_SIZE;++cx) {
+        for(int cz=0;cz<CHUNK_SIZE;++cz) {
+            if(blocksCache[cx][cz]==WATER){
+                for(int dir=0;dir<8;++dir) {
+                    int nx=cx+dx[dir];
+                    int nz=cz+dz[dir];
+                    if(nx>=0&&nx<CHUNK_SIZE&&nz>=0&&nz<CHUNK_SIZE&&blocksCache2[nx][nz]!=WATER) {
+                        blocksCache[cx][cz]=blocks.at(nx,WATERH,nz);
+						break;
+                    }
+                }
+            }
+        }
+    }
+    for(int cx=0;cx<CHUNK_SIZE;++cx) {
+        for(int cz=0;cz<CHUNK_SIZE;++cz) {
+            if(blocksCache[cx][cz]!=WATER) {
+                if(cx-1>= 0)blocksCache2[cx-1][cz]=SAND;
+                if(cx+1<CHUNK_SIZE)blocksCache2[cx+1][cz]=SAND;
+                if(cz-1>=0)blocksCache2[cx][cz-1]=SAND;
+                if(cz+1<CHUNK_SIZE)blocksCache2[cx][cz+1]=SAND;
+            }
+        }
+    }
+    memcpy(blocksCache, blocksCache2, sizeof(blocksCache));
+    for(int cx=0;cx<CHUNK_SIZE;++cx) {
+        for(int cz=0;cz<CHUNK_SIZE;++cz) {
+            if(blocksCache2[cx][cz]==WATER) {
+                if(cx-1>= 0)blocksCache[cx-1][cz]=WATER;
+                if(cx+1<CHUNK_SIZE)blocksCache[cx+1][cz]=WATER;
+                if(cz-1 >=0)blocksCache[cx][cz-1]=WATER;
+                if(cz+1<CHUNK_SIZE)blocksCache[cx][cz+1]=WATER;
+            }
+        }
+    }
+    for(int cx=0; cx<CHUNK_SIZE; ++cx) {
+        for(int cz=0; cz<CHUNK_SIZE; ++cz) {
+			blocks.at(cx,WATERH,cz)=blocksCache[cx][cz];
+        }
+    }
+
+    if(isJobCancelled(epoch)) return false;
+    //树生成：在草地上按生物群系概率生成树干（WOOD）和树冠（LEAVES）
+    for(int cx=0;cx<CHUNK_SIZE;++cx) {
+        for(int cz=0;cz<CHUNK_SIZE;++cz) {
+            float worldX=static_cast<float>(chunkX*CHUNK_SIZE+cx);
+            float worldZ=static_cast<float>(chunkZ*CHUNK_SIZE+cz);
+            int topY=heightMap[cx][cz];
+            if(topY<=0 || topY>=worldHeight-8) continue;//留空间给树冠
+            int groundY=topY-1;
+            if(groundY<0) continue;
+            if(blocks.at(cx,groundY,cz)!=GRASS) continue;//只在草方块上
+
+            BiomeType biome=getBiome(worldX,worldZ,topY);
+
+            //避免在靠近 chunk 边缘处生成树（防止树冠跨 chunk 被切割）
+            const int borderMargin=4;//应>=最大叶冠半径
+            if(cx<borderMargin || cz<borderMargin || cx>=CHUNK_SIZE-borderMargin || cz>=CHUNK_SIZE-borderMargin) continue;
+            //Use a deterministic per-cell hash RNG to avoid large coherent patches from low-frequency noise.
+            //Keep Perlin to modulate some variability,but make placement primarily probabilistic per cell.
+            float treeNoise=octavePerlin(worldX*0.25f+77.0f,worldZ*0.25f+91.0f,3,0.5f,2.0f,0.6f);
+            //lower base probabilities to reduce overall tree density
+            float spawnProb=0.0005f;
+            if(biome==BIOME_FOREST) spawnProb=0.004f;//still denser in forests but not overcrowded
+            else if(biome==BIOME_PLAINS) spawnProb=0.001f;
+            else if(biome==BIOME_DESERT || biome==BIOME_BEACH || biome==BIOME_OCEAN) spawnProb=0;
+            if(spawnProb<=0.0f) continue;
+
+            // 确定性哈希 -> [0,1)
+            float h = std::sin(worldX * 12.9898f + worldZ * 78.233f) * 43758.5453f;
+            float cellRand = h - std::floor(h);
+
+            // 根据噪声微调生成概率
+            float noiseFactor = 1.5f + 0.5f * treeNoise; // ~[0,1]
+            float effectiveProb = spawnProb * (0.5f + noiseFactor * 0.5f);
+            if (cellRand >= effectiveProb) continue; // 不生成
+
+            // 避免在 chunk 内将树生成得过于靠近
+            const int minDist = 3; // 最小间距
+            bool tooClose = false;
+            int nx0 = std::max(0, cx - minDist);
+            int nx1 = std::min(CHUNK_SIZE - 1, cx + minDist);
+            int nz0 = std::max(0, cz - minDist);
+            int nz1 = std::min(CHUNK_SIZE - 1, cz + minDist);
+            int checkTop = std::min(worldHeight - 1, topY + 6);
+            for (int nx = nx0; nx <= nx1 && !tooClose; ++nx) {
+                for (int nz = nz0; nz <= nz1; ++nz) {
+                    for (int yy = topY; yy <= checkTop; ++yy) {
+                        BlockType b = blocks.at(nx,yy,nz);
+                        if (b == WOOD || b == LEAVES) { tooClose = true; break; }
+                    }
+                    if(tooClose) break;
+                }
+            }
+            if(tooClose) continue;
+
+            //树干高度：降低基准并减小可变范围，使树总体更矮小
+            float hNoise=octavePerlin(worldX*0.17f+600.0f,worldZ*0.17f+600.0f,2,0.5f,2.0f,0.8f);
+            //base 3,variable ~0..2 -> typical heights ~3..5
+            int trunkH=4+static_cast<int>((hNoise+1.0f)*2.0f);
+            trunkH=std::min(trunkH,worldHeight-4-topY);
+            bool canPlace=true;
+            for(int y=topY;y<topY+trunkH;++y) {
+                if(y>=worldHeight || blocks.at(cx,y,cz)!=AIR) { canPlace=false;break;}
+            }
+            if(!canPlace) continue;
+            for(int y=topY;y<topY+trunkH;++y) blocks.at(cx,y,cz)=WOOD;
+
+            int leafBase=topY+trunkH-1;
+            //叶冠：近似球/分层
+            for(int lx=-3;lx<=3;++lx) {
+                for(int lz=-3;lz<=3;++lz) {
+                    for(int ly=0;ly<=3;++ly) {
+                        int ax=cx+lx;
+                        int ay=leafBase+ly;
+                        int az=cz+lz;
+                        if(ax<0 || ax>=CHUNK_SIZE || ay<0 || ay>=worldHeight || az<0 || az>=CHUNK_SIZE) continue;
+                        float dist2=(float)lx*lx+(float)lz*lz+(float)ly*ly*0.7f;
+                        //更小的阈值，减少叶子扩展
+                        if(dist2<=11.5f) {
+                            if(blocks.at(ax,ay,az)==AIR) blocks.at(ax,ay,az)=LEAVES;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if(isJobCancelled(epoch)) return false;
+    //=== 云生成 ===
+    const int CLOUD_BASE=getCloudLevel();
+    const int CLOUD_THICKNESS=1;
+    const float CLOUD_SCALE=0.04f;
+    const float CLOUD_THRESHOLD=0.38f;
+    //highY 以上的区段整段为空气，云直接写入压缩存储
+    std::vector<glm::ivec3> cloudCells;
+    for(int cx=0;cx<CHUNK_SIZE;++cx) {
+        for(int cz=0;cz<CHUNK_SIZE;++cz) {
+            float worldX=static_cast<float>(chunkX*CHUNK_SIZE+cx);
+            float worldZ=static_cast<float>(chunkZ*CHUNK_SIZE+cz);
+            float n=octavePerlin(worldX*CLOUD_SCALE,worldZ*CLOUD_SCALE,3,0.5f,2.0f,1.0f);
+            if(n>CLOUD_THRESHOLD) {
+                for(int cy=0;cy<CLOUD_THICKNESS;++cy) {
+                    int y=CLOUD_BASE+cy;
+                    if(y<0 || y>=worldHeight) continue;
+                    if(y>=highY) cloudCells.push_back(glm::ivec3(cx,y,cz));
+                    else if(blocks.at(cx,y,cz)==AIR) blocks.at(cx,y,cz)=CLOUD;
+                }
+            }
+        }
+    }
+
+    //最后一个检查点：之后才写入方块存储
+    if(isJobCancelled(epoch)) return false;
+    storeBlocks(blocks,lowY,highY);
+    if(!cloudCells.empty()) {
+        std::lock_guard<std::mutex> lk(storageMutex);
+        for(const glm::ivec3 &c : cloudCells) {
+            ChunkSection &sec=sections[c.y/SECTION_SIZE];
+            sec.blocks.set(PalettedContainer::indexOf(c.x,c.y%SECTION_SIZE,c.z),CLOUD);
+            sec.nonAirCount++;
+            updateColumn(c.x,c.y,c.z,AIR,CLOUD);
+        }
+    }
+    needsUpdate=true;
+    return true;
+}
+
+//检查某个面是否可见（用于 Greedy Meshing）：邻居直接读快照，chunk 边界外的一格来自邻居 chunk
+bool Chunk::isFaceVisible(const PaddedBlocks &blocks,int x,int y,int z,int face,BlockType blockType) {
+    if(blockType==AIR) return false;
+    if(blockType==LEAVES) return true;
+    static const int dx[6]={ 0,0,-1,1,0,0 };
+    static const int dy[6]={ 0,0,0,0,1,-1 };
+    static const int dz[6]={ 1,-1,0,0,0,0 };
+    //世界高度范围内、内容范围外的层全为空气
+    BlockType neighbor=blocks.get(x+dx[face],y+dy[face],z+dz[face],AIR);
+    return (neighbor==AIR || (blockType!=WATER && neighbor==WATER));
+}
+
+//将每个纹理组的顶点上传到 GPU，并设置顶点属性指针
+//VBO 已有的显存足够时只更新子数据（复用池中 chunk 的缓冲），不够时按 1.25 倍重新分配留出余量
+void Chunk::uploadVertexBuffers(const MeshData &data) {
+    for(int i=0;i<NUM_BLOCK_TEXTURES;++i) {
+        const std::vector<PackedVertex> &vertices=data.verticesByType[i];
+        if(vertices.empty()) continue;
+        glBindVertexArray(VAOs[i]);
+        glBindBuffer(GL_ARRAY_BUFFER,VBOs[i]);
+        size_t bytes=vertices.size()*sizeof(PackedVertex);
+        if(bytes>gpuCapacity[i]) {
+            gpuCapacity[i]=bytes+bytes/4;
+            glBufferData(GL_ARRAY_BUFFER,gpuCapacity[i],nullptr,GL_STATIC_DRAW);
+        }
+        glBufferSubData(GL_ARRAY_BUFFER,0,bytes,vertices.data());
+        //打包顶点只有一个整数属性（两个 uint32），由着色器解码位置、UV 与法线
+        glVertexAttribIPointer(3,2,GL_UNSIGNED_INT,sizeof(PackedVertex),(void*)0);
+        glEnableVertexAttribArray(3);
+        bindQuadIndexBuffer(vertices.size()/QUAD_VERTICES);
+    }
+}
+
+void Chunk::takeMeshLayout(MeshData &data) {
+    std::memcpy(faceOffsets,data.faceOffsets,sizeof(faceOffsets));
+    meshBottom=data.meshBottom;
+    meshTop=data.meshTop;
+    for(int i=0;i<NUM_BLOCK_TEXTURES;++i) transparentCentroids[i]=std::move(data.transparentCentroids[i]);
+}
+
+size_t Chunk::meshResidentBytes() const {
+    size_t bytes=sizeof(faceOffsets);
+    for(const auto &c : transparentCentroids) bytes+=c.capacity()*sizeof(uint32_t);
+    return bytes;
+}
+
+size_t Chunk::meshVertexBytes() const {
+    size_t quads=0;
+    for(int i=0;i<NUM_BLOCK_TEXTURES;++i) quads+=quadCount(i);
+    return quads*QUAD_VERTICES*sizeof(PackedVertex);
+}
+
+//面方向 f 的所有面平面都在包围盒内：相机在包围盒对应一侧之外（含平面上）时，该方向的面全部背向相机
+uint8_t Chunk::visibleFaceMask(const glm::vec3 &cameraPos) const {
+    const float x0=static_cast<float>(chunkX*CHUNK_SIZE),z0=static_cast<float>(chunkZ*CHUNK_SIZE);
+    uint8_t mask=0;
+    if(cameraPos.z>z0) mask|=1<<0;
+    if(cameraPos.z<z0+CHUNK_SIZE) mask|=1<<1;
+    if(cameraPos.x<x0+CHUNK_SIZE) mask|=1<<2;
+    if(cameraPos.x>x0) mask|=1<<3;
+    if(cameraPos.y>meshBottom) mask|=1<<4;
+    if(cameraPos.y<meshTop) mask|=1<<5;
+    return mask;
+}
+
+//调用方已绑定对应 VAO；索引缓冲中第 q 个四边形的索引从 q*QUAD_INDICES 开始
+size_t Chunk::drawFaceRanges(int texIndex,uint8_t faceMask) const {
+    const FaceOffsets &range=faceOffsets[texIndex];
+    size_t quads=0;
+    for(int f=0;f<6;) {
+        if(!(faceMask&(1<<f))) { ++f;continue;}
+        uint32_t begin=range[f];
+        while(f<6 && (faceMask&(1<<f))) ++f;
+        uint32_t end=range[f];
+        if(end<=begin) continue;
+        glDrawElements(GL_TRIANGLES,static_cast<GLsizei>((end-begin)*QUAD_INDICES),GL_UNSIGNED_INT,(void*)(static_cast<size_t>(begin)*QUAD_INDICES*sizeof(uint32_t)));
+        quads+=end-begin;
+    }
+    return quads;
+}
+
+size_t Chunk::opaqueQuadCount() const {
+    size_t quads=0;
+    for(int i=0;i<NUM_BLOCK_TEXTURES;++i)
+        if(!isTransparentGroup(i)) quads+=quadCount(i);
+    return quads;
+}
+
+//渲染：按每个纹理组绑定对应纹理，只绘制可能朝向相机的面方向
+size_t Chunk::renderOpaque(Shader &shader,const glm::vec3* cameraPos) {
+    const uint8_t faceMask=cameraPos ? visibleFaceMask(*cameraPos) : 0x3F;
+    shader.setVec3("chunkOrigin",meshOrigin());
+    size_t quads=0;
+    //Opaque pass: draw all non-transparent texture groups and update depth buffer
+    for(int i=0;i<NUM_BLOCK_TEXTURES;++i) {
+        if(isTransparentGroup(i)) continue;
+        if(quadCount(i)==0) continue;
+        float specular=0.1f;
+        if(i==6) specular=1.0f;
+        else if(i==5 || i==0 || i==7) specular=0.0f;
+        else if(i==2) specular=0.05f;
+        shader.setFloat("specularStrength",specular);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D,blockTextures[i]);
+        glBindVertexArray(VAOs[i]);
+        quads+=drawFaceRanges(i,faceMask);
+    }
+    return quads;
+}
+
+//Note: per-chunk transparent draw is unused when World performs global sorting.
+void Chunk::renderTransparent(Shader &shader,const glm::vec3* viewDir,const glm::vec3* cameraPos,const glm::vec3* lightDir) {
+}
+
+void Chunk::renderDepth(Shader &depthShader,const glm::vec3* towardLight) {
+    //正交的方向光下，法线与指向光源的方向点积不为正的面在阴影贴图中是背面或侧对光源
+    static const glm::vec3 normals[6]={ {0,0,1},{0,0,-1},{-1,0,0},{1,0,0},{0,1,0},{0,-1,0} };
+    uint8_t faceMask=0x3F;
+    if(towardLight) {
+        faceMask=0;
+        for(int f=0;f<6;++f)
+            if(glm::dot(normals[f],*towardLight)>0.0f) faceMask|=1<<f;
+    }
+    depthShader.setVec3("chunkOrigin",meshOrigin());
+    for(int i=0;i<NUM_BLOCK_TEXTURES;++i) {
+        if(quadCount(i)==0) continue;
+        glBindVertexArray(VAOs[i]);
+        drawFaceRanges(i,faceMask);
+    }
+}
+
+//逐方块的参考实现：每格每面调用 isFaceVisible，用 merged 数组记录已合并的面
+MeshData Chunk::buildMeshCPUScalar(const MeshSnapshot &snapshot) {
+    MeshData out;out.chunkX=snapshot.chunkX;out.chunkZ=snapshot.chunkZ;
+    out.missingSides=snapshot.missingSides;
+    out.editVersion=snapshot.editVersion;
+    out.meshBottom=snapshot.blocks.getBaseY();
+    out.meshTop=snapshot.meshTop;
+    MeshScratch &scratch=threadMeshScratch();
+    scratch.clearVertices();
+    std::vector<PackedVertex>* tempBuffers=scratch.vertices;
+    const PaddedBlocks &blocks=snapshot.blocks;
+    const std::vector<SectionFlags> &sectionFlags=snapshot.sectionFlags;
+    const int meshTop=snapshot.meshTop;//高于所有列顶的层不可能产生面，纵向扫描只到这里
+    //低于最低非空区段的层全为空气，纵向扫描从这里开始
+    const int meshBottom=blocks.getBaseY();
+    DenseVolume<MergeState> &merged=scratch.merged;
+    merged.resize(blocks.getBaseY(),blocks.getTopY(),NOT_MERGED);
+    //Always process all 6 faces forCPU mesh
+    for(int face=0;face<6;++face) {
+        merged.fill(NOT_MERGED);
+        int size1,size2,size3;//traversal dimensions mapping
+        if(face==0 || face==1) { 
+            size1=CHUNK_SIZE;
+            size2=meshTop;
+            size3=CHUNK_SIZE;
+        }else if(face==2 || face==3) {
+            size1=CHUNK_SIZE;
+            size2=meshTop;
+            size3=CHUNK_SIZE;
+        }else { 
+            size1=CHUNK_SIZE;
+            size2=CHUNK_SIZE;
+            size3=meshTop;
+        }
+        int start2=(face==4 || face==5) ? 0 : meshBottom;
+        int start3=(face==4 || face==5) ? meshBottom : 0;
+        for(int d3=start3;d3<size3;++d3) {
+            for(int d2=start2;d2<size2;++d2) {
+                int rowY=(face==4 || face==5) ? d3 : d2;
+                if(isUniformInterior(sectionFlags.data(),face,d3,rowY)) continue;
+                for(int d1=0;d1<size1;++d1) {
+                    int x,y,z;
+                    if(face==0 || face==1) {
+                        x=d1;y=d2;z=d3;
+                    }else if(face==2 || face==3) {
+                        x=d3;y=d2;z=d1;
+                    }else{ x=d1;y=d3;z=d2;}
+                    if(merged.at(x,y,z)) continue;
+                    BlockType bt=blocks.at(x,y,z);
+                    if(bt==AIR) continue;
+                    if(!isFaceVisible(blocks,x,y,z,face,bt)) continue;
+                    //width expansion
+                    int width=1;
+                    while (d1+width<size1) {
+                        int nx,ny,nz;
+                        if(face==0||face==1){ 
+                            nx=d1+width;
+                            ny=d2;
+                            nz=d3;
+                        } else if(face==2||face==3){ 
+                            nx=d3;
+                            ny=d2;
+                            nz=d1+width;
+                        } else {
+                            nx=d1+width;
+                            ny=d3;
+                            nz=d2;
+                        }
+                        if(merged.at(nx,ny,nz)) break;
+                        if(blocks.at(nx,ny,nz)!=bt) break;
+                        if(!isFaceVisible(blocks,nx,ny,nz,face,bt)) break;
+                        ++width;
+                    }
+                    //height expansion
+                    int height=1;
+                    bool canExtend=true;
+                    while(canExtend && d2+height<size2) {
+                        for(int w=0;w<width;++w){ 
+                            int nx,ny,nz;
+                            if(face==0||face==1){ 
+                                nx=d1+w;
+                                ny=d2+height;
+                                nz=d3;
+                            } else if(face==2||face==3){
+                                nx=d3;
+                                ny=d2+height;
+                                nz=d1+w;
+                            } else { 
+                                nx=d1+w;
+                                ny=d3;
+                                nz=d2+height;
+                            }
+                            if(merged.at(nx,ny,nz) || blocks.at(nx,ny,nz)!=bt || !isFaceVisible(blocks,nx,ny,nz,face,bt)){ 
+                                canExtend=false;
+                                break;
+                            }
+                        }
+                        if(canExtend) ++height;
+                    }
+                    //mark merged
+                    for(int h=0;h<height;++h){ 
+                        for(int w=0;w<width;++w){
+                            int nx,ny,nz;
+                            if(face==0||face==1){ 
+                                nx=d1+w;
+                                ny=d2+h;
+                                nz=d3;
+                            } else if(face==2||face==3){ 
+                                nx=d3;
+                                ny=d2+h;
+                                nz=d1+w;
+                            } else {
+                                nx=d1+w;
+                                ny=d3;
+                                nz=d2+h;
+                            } merged.at(nx,ny,nz)=MERGED;
+                        }
+                    }
+                    emitQuad(tempBuffers,x,y,z,width,height,face,bt);
+                }
+            }
+        }
+        markFaceEnd(tempBuffers,out.faceOffsets,face);
+    }
+    scratch.copyVerticesTo(out);
+    packTransparentCentroids(out);
+    return out;
+}
+
+//位掩码网格构建：每行（固定 y,z）方块先分类成掩码，可见面由相邻行的掩码按位运算得到；
+//贪婪合并在掩码上取最低位、清除已合并的位，只对可见面读方块类型。输出与 buildMeshCPUScalar 逐字节相同
+//六个面方向各是 RowMesher::meshDirection 的一个实例
+MeshData Chunk::buildMeshCPU(const MeshSnapshot &snapshot) {
+    MeshData out;out.chunkX=snapshot.chunkX;out.chunkZ=snapshot.chunkZ;
+    out.missingSides=snapshot.missingSides;
+    out.editVersion=snapshot.editVersion;
+    out.meshBottom=snapshot.blocks.getBaseY();
+    out.meshTop=snapshot.meshTop;
+    MeshScratch &scratch=threadMeshScratch();
+    scratch.clearVertices();
+    std::vector<PackedVertex>* tempBuffers=scratch.vertices;
+    RowMesher mesher(snapshot,scratch);
+    mesher.meshDirection<FacePosZ>();
+    markFaceEnd(tempBuffers,out.faceOffsets,FacePosZ::FACE);
+    mesher.meshDirection<FaceNegZ>();
+    markFaceEnd(tempBuffers,out.faceOffsets,FaceNegZ::FACE);
+    mesher.meshDirection<FaceNegX>();
+    markFaceEnd(tempBuffers,out.faceOffsets,FaceNegX::FACE);
+    mesher.meshDirection<FacePosX>();
+    markFaceEnd(tempBuffers,out.faceOffsets,FacePosX::FACE);
+    mesher.meshDirection<FacePosY>();
+    markFaceEnd(tempBuffers,out.faceOffsets,FacePosY::FACE);
+    mesher.meshDirection<FaceNegY>();
+    markFaceEnd(tempBuffers,out.faceOffsets,FaceNegY::FACE);
+    scratch.copyVerticesTo(out);
+    packTransparentCentroids(out);
+    return out;
+}
+
+void Chunk::uploadMeshFromData(MeshData&& data) {
+    if(data.chunkX!=chunkX || data.chunkZ!=chunkZ) return;
+    takeMeshLayout(data);
+    ensureGpuLoaded();
+    uploadVertexBuffers(data);
+    needsUpdate=false;
+    pendingBuild=false;
+    meshMissingSides=data.missingSides;
+    meshUploaded=true;
+}
+
+//Collect transparent faces forglobal sorting. Each tuple: (depth,texIndex,faceIndex,chunkPtr)
+void Chunk::collectTransparentFaces(std::vector<std::tuple<float,int,int,Chunk*>> &out,const glm::vec3* viewDir,const glm::vec3* cameraPos) const {
+    const glm::vec3 origin=meshOrigin();
+    //collect leaves (4),water (6) and cloud (8) as transparent faces forglobal sorting
+    for(int i : {4,6,8}) {
+        if(i<0 || i>=NUM_BLOCK_TEXTURES) continue;
+        const auto &centroids=transparentCentroids[i];
+        for(size_t f=0;f<centroids.size();++f) {
+            glm::vec3 centroid=origin+unpackCentroid(centroids[f]);
+            float depth=0.0f;
+            if(viewDir!=nullptr) {
+                if(cameraPos!=nullptr) depth=glm::dot(centroid-*cameraPos,*viewDir);
+                else depth=glm::dot(centroid,*viewDir);
+            } else depth=centroid.z;
+            out.emplace_back(depth,i,static_cast<int>(f),const_cast<Chunk*>(this));
+        }
+    }
+}
+
+// 绘制单个透明面（设置 chunk 原点、绑定纹理/VAO 并绘制 faceIndex 的 6 个索引）
+void Chunk::drawTransparentFace(Shader &shader,int texIndex,int faceIndex) const {
+    if(texIndex<0 || texIndex>=NUM_BLOCK_TEXTURES) return;
+    if(static_cast<uint32_t>(faceIndex)>=quadCount(texIndex)) return;
+    shader.setVec3("chunkOrigin",meshOrigin());
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D,blockTextures[texIndex]);
+    glBindVertexArray(VAOs[texIndex]);
+    glDrawElements(GL_TRIANGLES,QUAD_INDICES,GL_UNSIGNED_INT,(void*)(static_cast<size_t>(faceIndex)*QUAD_INDICES*sizeof(uint32_t)));
 }
\ No newline at end of file
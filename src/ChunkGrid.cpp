@@ -0,0 +1,75 @@
+#include "../include/ChunkGrid.h"
+
+ChunkGrid::ChunkGrid(int minWidth) : shift(0) {
+    while ((1<<shift)<minWidth) ++shift;
+    mask=(1<<shift)-1;
+    slots.resize((size_t)1<<(shift*2));
+    published.reset(new std::atomic<Chunk*>[slots.size()]);
+    for(size_t i=0;i<slots.size();++i) published[i].store(nullptr);
+}
+
+Chunk* ChunkGrid::findOverflow(int chunkX,int chunkZ) const {
+    auto it=overflow.find({chunkX,chunkZ});
+    return it==overflow.end() ? nullptr : it->second.chunk;
+}
+
+ChunkGrid::Slot* ChunkGrid::findSlot(int chunkX,int chunkZ) {
+    Slot &s=slots[slotIndex(chunkX,chunkZ)];
+    if(s.x==chunkX && s.z==chunkZ) return &s;
+    auto it=overflow.find({chunkX,chunkZ});
+    return it==overflow.end() ? nullptr : &it->second;
+}
+
+void ChunkGrid::insert(Chunk* chunk) {
+    Slot entry;
+    entry.x=chunk->getChunkX();
+    entry.z=chunk->getChunkZ();
+    entry.chunk=chunk;
+    entry.liveIndex=static_cast<int>(live.size());
+    live.push_back(chunk);
+    Slot &s=slots[slotIndex(entry.x,entry.z)];
+    if(s.chunk==nullptr) {
+        s=entry;
+        publish(s);
+    } else overflow[{entry.x,entry.z}]=entry;
+}
+
+Chunk* ChunkGrid::erase(int chunkX,int chunkZ) {
+    Slot* s=findSlot(chunkX,chunkZ);
+    if(!s) return nullptr;
+    Chunk* chunk=s->chunk;
+    int idx=s->liveIndex;
+    if(s>=slots.data() && s<slots.data()+slots.size()) {
+        *s=Slot();
+        publish(*s);
+    } else overflow.erase({chunkX,chunkZ});
+
+    //与末尾交换，保持存活列表紧凑
+    Chunk* moved=live.back();
+    live.pop_back();
+    if(moved!=chunk) {
+        live[idx]=moved;
+        findSlot(moved->getChunkX(),moved->getChunkZ())->liveIndex=idx;
+    }
+    return chunk;
+}
+
+void ChunkGrid::recenter(int chunkX,int chunkZ) {
+    if(overflow.empty()) return;
+    //以玩家为中心、边长为网格宽度的窗口内坐标互不冲突
+    const int half=(1<<shift)/2;
+    auto inWindow=[&](int x,int z) { return x>=chunkX-half && x<chunkX+half && z>=chunkZ-half && z<chunkZ+half;};
+    for(auto it=overflow.begin();it!=overflow.end();) {
+        Slot &s=slots[slotIndex(it->first.first,it->first.second)];
+        if(s.chunk!=nullptr && (!inWindow(it->first.first,it->first.second) || inWindow(s.x,s.z))) {
+            ++it;
+            continue;
+        }
+        Slot incoming=it->second;
+        it=overflow.erase(it);
+        //槽位被窗口外的 chunk 占用：让出槽位进入溢出表
+        if(s.chunk!=nullptr) overflow[{s.x,s.z}]=s;
+        s=incoming;
+        publish(s);
+    }
+}
@@ -0,0 +1,53 @@
+#include "../include/ChunkPool.h"
+#include <iostream>
+
+ChunkPool::ChunkPool() : highWaterMark(DEFAULT_HIGH_WATER_MARK) {
+    freeList.reserve(highWaterMark);
+}
+
+ChunkPool::~ChunkPool() {
+    for(Chunk* c : freeList) delete c;
+}
+
+Chunk* ChunkPool::acquire(int chunkX,int chunkZ) {
+    if(freeList.empty()) {
+        ++misses;
+        return new Chunk(chunkX,chunkZ);
+    }
+    ++hits;
+    Chunk* c=freeList.back();
+    freeList.pop_back();
+    c->reset(chunkX,chunkZ);
+    return c;
+}
+
+void ChunkPool::release(Chunk* chunk) {
+    if(!chunk) return;
+    if(freeList.size()>=highWaterMark) {
+        ++discards;
+        delete chunk;
+        return;
+    }
+    freeList.push_back(chunk);
+}
+
+void ChunkPool::setHighWaterMark(size_t n) {
+    highWaterMark=n;
+    trim();
+}
+
+void ChunkPool::trim() {
+    while (freeList.size()>highWaterMark) {
+        delete freeList.back();
+        freeList.pop_back();
+        ++discards;
+    }
+}
+
+void ChunkPool::printStats() const {
+    size_t total=hits+misses;
+    double hitRate=total>0 ? 100.0*(double)hits/(double)total : 0.0;
+    std::cout<<"[ChunkPool] free="<<freeList.size()<<"/"<<highWaterMark
+        <<" hits="<<hits<<" misses="<<misses<<" ("<<hitRate<<"% reuse)"
+        <<" discarded="<<discards<<std::endl;
+}
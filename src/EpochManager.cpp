@@ -0,0 +1,57 @@
+#include "../include/EpochManager.h"
+#include <iostream>
+#include <cstdlib>
+
+namespace {
+    //读者线程槽位：所有 EpochManager 共用同一套槽位编号
+    std::atomic<bool> g_slotInUse[EpochManager::MAX_READERS];
+
+    struct ThreadSlot {
+        int index=-1;
+        ThreadSlot() {
+            for(int i=0;i<EpochManager::MAX_READERS;++i) {
+                bool expected=false;
+                if(g_slotInUse[i].compare_exchange_strong(expected,true)) {
+                    index=i;
+                    return;
+                }
+            }
+            std::cout<<"[Epoch] too many reader threads (max "<<EpochManager::MAX_READERS<<")"<<std::endl;
+            std::abort();
+        }
+        ~ThreadSlot() { g_slotInUse[index].store(false);}
+    };
+
+    int currentThreadSlot() {
+        thread_local ThreadSlot slot;
+        return slot.index;
+    }
+}
+
+EpochManager::EpochManager() {}
+
+EpochManager::ReadGuard::ReadGuard(const EpochManager& manager) : manager(manager),slot(currentThreadSlot()) {
+    ReaderSlot &r=manager.readers[slot];
+    outer=(r.depth++==0);
+    //登记与随后读取发布指针都用 seq_cst，保证与写者的“撤下指针→推进纪元→扫描读者”全序可比
+    if(outer) r.epoch.store(manager.globalEpoch.load());
+}
+
+EpochManager::ReadGuard::~ReadGuard() {
+    ReaderSlot &r=manager.readers[slot];
+    --r.depth;
+    if(outer) r.epoch.store(0,std::memory_order_release);
+}
+
+uint64_t EpochManager::retire() {
+    return globalEpoch.fetch_add(1);
+}
+
+uint64_t EpochManager::safeEpoch() const {
+    uint64_t safe=globalEpoch.load();
+    for(int i=0;i<MAX_READERS;++i) {
+        uint64_t e=readers[i].epoch.load();
+        if(e!=0 && e<safe) safe=e;
+    }
+    return safe;
+}
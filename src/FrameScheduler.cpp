@@ -0,0 +1,121 @@
+#include "../include/FrameScheduler.h"
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+
+namespace {
+    constexpr double MIN_BUDGET_MS=1.0;
+    constexpr double MAX_BUDGET_MS=12.0;
+    constexpr double ADAPT_GAIN=0.25;//每帧按 (目标-实际) 的四分之一调整预算
+    constexpr double COST_SMOOTHING=0.2;//单位耗时滑动平均中新样本的权重
+
+    double msSince(std::chrono::steady_clock::time_point t) {
+        return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t).count();
+    }
+}
+
+FrameSlice::FrameSlice(int maxUnits) : maxUnits(maxUnits),start(std::chrono::steady_clock::now()) {}
+
+bool FrameSlice::more(double w) const {
+    if(units>=maxUnits) return false;
+    if(units<minUnits || allowedMs<0.0) return true;
+    return elapsedMs()+costPerWeight*w<=allowedMs;
+}
+
+void FrameSlice::done(double w) {
+    ++units;
+    weight+=w;
+}
+
+double FrameSlice::elapsedMs() const {
+    return msSince(start);
+}
+
+FrameScheduler::FrameScheduler(double targetFrameMs) : targetFrameMs(targetFrameMs),budgetMs(targetFrameMs*0.25) {
+    frameStart=std::chrono::steady_clock::now();
+}
+
+int FrameScheduler::addTask(const char* name,float share,int minUnits,int maxUnits,double initialCostMs) {
+    Task t;
+    t.name=name;
+    t.share=share;
+    t.minUnits=minUnits;
+    t.maxUnits=maxUnits;
+    t.costPerWeight=initialCostMs;
+    tasks.push_back(t);
+    return static_cast<int>(tasks.size())-1;
+}
+
+void FrameScheduler::beginFrame() {
+    frameStart=std::chrono::steady_clock::now();
+    usedMs=0.0;
+    for(auto &t : tasks) {
+        t.ranThisFrame=false;
+        t.frameMs=0.0;
+        t.frameUnits=0;
+    }
+}
+
+//剩余预算按份额分给本帧尚未运行的任务（先运行的任务用不完的部分留给后面的任务）
+FrameSlice FrameScheduler::begin(int task) {
+    Task &t=tasks[task];
+    float pendingShare=0.0f;
+    for(const auto &o : tasks)
+        if(!o.ranThisFrame) pendingShare+=o.share;
+    double remaining=std::max(0.0,budgetMs-usedMs);
+    FrameSlice s;
+    s.task=task;
+    s.minUnits=t.minUnits;
+    s.maxUnits=t.maxUnits;
+    s.allowedMs=(t.ranThisFrame || pendingShare<=0.0f) ? remaining : remaining*t.share/pendingShare;
+    s.costPerWeight=t.costPerWeight;
+    s.start=std::chrono::steady_clock::now();
+    return s;
+}
+
+void FrameScheduler::end(const FrameSlice &slice) {
+    Task &t=tasks[slice.task];
+    double ms=slice.elapsedMs();
+    usedMs+=ms;
+    t.ranThisFrame=true;
+    t.frameMs+=ms;
+    t.frameUnits+=slice.units;
+    if(slice.weight>0.0)
+        t.costPerWeight+=COST_SMOOTHING*(ms/slice.weight-t.costPerWeight);
+}
+
+void FrameScheduler::endFrame() {
+    double workMs=msSince(frameStart);
+    //有余量就放宽、超出目标就收缩；限制在 [MIN,MAX] 内，避免单帧尖峰把预算打到 0
+    budgetMs=std::min(MAX_BUDGET_MS,std::max(MIN_BUDGET_MS,budgetMs+ADAPT_GAIN*(targetFrameMs-workMs)));
+
+    ++frames;
+    sumWorkMs+=workMs;
+    maxWorkMs=std::max(maxWorkMs,workMs);
+    sumBudgetMs+=budgetMs;
+    for(auto &t : tasks) {
+        t.sumMs+=t.frameMs;
+        t.maxMs=std::max(t.maxMs,t.frameMs);
+        t.sumUnits+=t.frameUnits;
+    }
+    if(!printEachFrame) return;
+    std::cout<<std::fixed<<std::setprecision(2)<<"[Frame] work="<<workMs<<"ms nextBudget="<<budgetMs<<"ms";
+    for(const auto &t : tasks)
+        std::cout<<" "<<t.name<<"="<<t.frameMs<<"ms/"<<t.frameUnits;
+    std::cout<<std::defaultfloat<<std::endl;
+}
+
+void FrameScheduler::printSummary() {
+    if(frames==0) return;
+    std::cout<<std::fixed<<std::setprecision(2)<<"[Frame] "<<frames<<" frames: work avg "<<sumWorkMs/frames<<"ms max "<<maxWorkMs
+        <<"ms, budget avg "<<sumBudgetMs/frames<<"ms (target "<<targetFrameMs<<"ms)"<<std::endl;
+    for(auto &t : tasks) {
+        std::cout<<"[Frame]   "<<t.name<<": avg "<<t.sumMs/frames<<"ms max "<<t.maxMs<<"ms, "
+            <<(double)t.sumUnits/frames<<" units/frame, est "<<std::setprecision(4)<<t.costPerWeight<<std::setprecision(2)<<"ms/unit"<<std::endl;
+        t.sumMs=t.maxMs=0.0;
+        t.sumUnits=0;
+    }
+    std::cout<<std::defaultfloat;
+    frames=0;
+    sumWorkMs=maxWorkMs=sumBudgetMs=0.0;
+}
@@ -0,0 +1,111 @@
+#include "../include/JobSystem.h"
+
+namespace {
+    //当前线程所属的任务系统与工作线程序号（非工作线程为 nullptr/-1）
+    thread_local const JobSystem* t_owner=nullptr;
+    thread_local int t_workerIndex=-1;
+
+    //空闲时先自旋几轮再休眠，避免短暂空档里频繁进出条件变量
+    constexpr int IDLE_SPINS=64;
+}
+
+JobSystem::JobSystem(unsigned threadCount) {
+    if(threadCount==0) {
+        unsigned hw=std::thread::hardware_concurrency();
+        threadCount=hw>1 ? hw-1 : 1;
+    }
+    for(unsigned i=0;i<threadCount;++i) queues.emplace_back(new WorkerQueue());
+    for(unsigned i=0;i<threadCount;++i) threads.emplace_back([this,i]() { workerMain(i);});
+}
+
+JobSystem::~JobSystem() {
+    running=false;
+    {
+        std::lock_guard<std::mutex> lk(sleepMutex);
+        sleepCv.notify_all();
+    }
+    for(auto &t : threads)
+        if(t.joinable()) t.join();
+}
+
+void JobSystem::submit(Job job) {
+    unsigned target;
+    if(t_owner==this) target=static_cast<unsigned>(t_workerIndex);
+    else target=nextQueue.fetch_add(1,std::memory_order_relaxed)%queues.size();
+    ++unfinishedJobs;
+    {
+        std::lock_guard<std::mutex> lk(queues[target]->mutex);
+        queues[target]->jobs.push_back(std::move(job));
+    }
+    ++queuedJobs;
+    //休眠者在持有 sleepMutex 时检查 queuedJobs，这里持锁通知不会丢失唤醒
+    if(sleepers.load()>0) {
+        std::lock_guard<std::mutex> lk(sleepMutex);
+        sleepCv.notify_one();
+    }
+}
+
+bool JobSystem::tryPop(unsigned self,Job &out) {
+    if(queuedJobs.load(std::memory_order_relaxed)<=0) return false;
+    {
+        WorkerQueue &own=*queues[self];
+        std::lock_guard<std::mutex> lk(own.mutex);
+        if(!own.jobs.empty()) {
+            out=std::move(own.jobs.front());
+            own.jobs.pop_front();
+            --queuedJobs;
+            return true;
+        }
+    }
+    //从下一个队列开始依次窃取，分散各线程的窃取目标
+    const unsigned count=static_cast<unsigned>(queues.size());
+    for(unsigned k=1;k<count;++k) {
+        WorkerQueue &victim=*queues[(self+k)%count];
+        std::lock_guard<std::mutex> lk(victim.mutex);
+        if(victim.jobs.empty()) continue;
+        out=std::move(victim.jobs.back());
+        victim.jobs.pop_back();
+        --queuedJobs;
+        steals.fetch_add(1,std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void JobSystem::workerMain(unsigned index) {
+    t_owner=this;
+    t_workerIndex=static_cast<int>(index);
+    int idle=0;
+    while (running) {
+        Job job;
+        if(tryPop(index,job)) {
+            idle=0;
+            job();
+            job=nullptr;//先释放任务捕获的资源，再报告完成
+            if(--unfinishedJobs==0) {
+                std::lock_guard<std::mutex> lk(idleMutex);
+                idleCv.notify_all();
+            }
+            continue;
+        }
+        if(++idle<IDLE_SPINS) {
+            std::this_thread::yield();
+            continue;
+        }
+        idle=0;
+        std::unique_lock<std::mutex> lk(sleepMutex);
+        ++sleepers;
+        sleepCv.wait(lk,[this]{ return queuedJobs.load()>0 || !running;});
+        --sleepers;
+    }
+}
+
+void JobSystem::waitIdle() {
+    std::unique_lock<std::mutex> lk(idleMutex);
+    idleCv.wait(lk,[this]{ return unfinishedJobs.load()==0;});
+}
+
+JobSystem& getJobSystem() {
+    static JobSystem system;
+    return system;
+}
@@ -1,463 +1,443 @@
-#include "../include/Common.h"
-#include "../include/Texture.h"
-
-#include <thread>
-#include <atomic>
-#include <mutex>
-#include <queue>
-#include <chrono>
-#include <vector>
-#include <string>
-#include <fstream>
-#include <algorithm>
-#include <cstdlib>
-
-//ǰ
-void stopTextureLoader();
-
-//
-constexpr int PANORAMA_COUNT=6;
-
-//ļб
-static const std::vector<std::string> g_panoFaces={
-    "minecraft_textures/gui/title/background/panorama_0.png",
-    "minecraft_textures/gui/title/background/panorama_1.png",
-    "minecraft_textures/gui/title/background/panorama_2.png",
-    "minecraft_textures/gui/title/background/panorama_3.png",
-    "minecraft_textures/gui/title/background/panorama_4.png",
-    "minecraft_textures/gui/title/background/panorama_5.png"
-};
-
-static const std::string g_titleTexturePath="minecraft_textures/gui/title/yourscraft.png";
-static const std::string g_subtitleTexturePath="minecraft_textures/gui/title/yourcraft_ch.png";
-
-static const std::vector<std::string> g_blockNames={
-    "grass_top.png",
-    "dirt.png",
-    "stone.png",
-    "planks_oak.png",
-    "leaves_oak.png",
-    "sand.png",
-    "water.png",
-    "grass_side.png",
-    "cloud.png"
-};
-
-static const std::string g_sphereTextureName="soccer.png";
-
-static const std::vector<std::string> g_blockSearchDirs={
-    "minecraft_textures/blocks/",
-    "minecraft_textures/"
-    ""
-};
-
-//ϴͼƬݽṹ
-struct PendingImage {
-    int texIndex=-1;
-    int imageType=0;//0 -> panoramaTextures[],1 -> blockTextures[],2 -> titleTexture,3 -> subtitleTexture,4 -> sphereTexture
-    std::vector<unsigned char> data;
-    int width=0,height=0,channels=0;
-};
-
-//첽ضͬ
-static std::queue<PendingImage> g_pendingUploads;
-static std::mutex g_pendingMutex;
-
-static std::queue<int> g_panoRequests;
-static std::queue<int> g_blockRequests;
-static std::queue<int> g_specialRequests;//title/subtitle/sphere 
-static std::mutex g_requestMutex;
-
-static std::atomic<bool> g_loaderRunning{ false };
-static std::thread* g_loaderThread=nullptr;
-
-static void enqueuePendingUpload(PendingImage&& img) {
-    std::lock_guard<std::mutex> lk(g_pendingMutex);
-    g_pendingUploads.push(std::move(img));
-}
-
-void requestPanoramaLoad(int index) {
-    std::lock_guard<std::mutex> lk(g_requestMutex);
-    if(index>=0 && index<(int)g_panoFaces.size())
-        g_panoRequests.push(index);
-}
-
-void requestBlockTextureLoad(int index) {
-    std::lock_guard<std::mutex> lk(g_requestMutex);
-    if(index>=0 && index<(int)g_blockNames.size())
-        g_blockRequests.push(index);
-}
-
-void requestTitleTextureLoad() {
-    std::lock_guard<std::mutex> lk(g_requestMutex);
-    g_specialRequests.push(-1);//title
-}
-
-void requestSubtitleTextureLoad() {
-    std::lock_guard<std::mutex> lk(g_requestMutex);
-    g_specialRequests.push(-2);//subtitle
-}
-
-void requestSphereTextureLoad() {
-    std::lock_guard<std::mutex> lk(g_requestMutex);
-    g_specialRequests.push(-3);//sphere
-}
-
-static void doLoadAndEnqueue(const std::string& path,int texIndex,int imageType) {
-    int w=0,h=0,c=0;
-    unsigned char* data=SOIL_load_image(path.c_str(),&w,&h,&c,SOIL_LOAD_AUTO);
-    if(!data) { std::cerr << "SOIL failed to load: " << path << "\n";return;}
-    PendingImage img;
-    img.texIndex=texIndex;
-    img.imageType=imageType;
-    img.width=w;img.height=h;img.channels=c;
-    img.data.assign(data,data+(w*h*c));
-    //ֱת
-    int rowSize=w*c;
-    for(int y=0;y<h/2;++y) {
-        unsigned char* top=img.data.data()+y*rowSize;
-        unsigned char* bot=img.data.data()+(h-1-y)*rowSize;
-        for(int x=0;x<rowSize;++x) std::swap(top[x],bot[x]);
-    }
-    SOIL_free_image_data(data);
-    enqueuePendingUpload(std::move(img));
-}
-
-static void loaderThreadMain() {
-    while (g_loaderRunning) {
-        int pidx=-4; //-4 , >=0 ȫ
-        int bidx=-1;
-        int sidx=-4;//: -1 title,-2 subtitle,-3 sphere
-        {
-            std::lock_guard<std::mutex> lk(g_requestMutex);
-            if(!g_panoRequests.empty()) { 
-                pidx=g_panoRequests.front();
-                g_panoRequests.pop();
-            }else if(!g_blockRequests.empty()){ 
-                bidx=g_blockRequests.front();
-                g_blockRequests.pop();
-            }else if(!g_specialRequests.empty()) {
-                sidx=g_specialRequests.front();
-                g_specialRequests.pop();
-            }
-        }
-        if(sidx==-2) {
-            std::ifstream f(g_subtitleTexturePath);
-            if(f.good()) {
-                f.close();
-                doLoadAndEnqueue(g_subtitleTexturePath,0,3);
-            }
-        }
-        else if(sidx==-1) {
-            std::ifstream f(g_titleTexturePath);
-            if(f.good()) {
-                f.close();
-            doLoadAndEnqueue(g_titleTexturePath,0,2);
-            }
-        }
-        else if(sidx==-3) {
-            //
-            std::string found;
-            for(auto &d : g_blockSearchDirs) {
-                std::string p=d+g_sphereTextureName;
-                std::ifstream f(p);
-                if(f.good()) { 
-                    f.close();
-                    found=p;
-                    break;
-                }
-            }
-            if(!found.empty()) doLoadAndEnqueue(found,0,4);
-        }
-        else if(pidx>=0) {
-            //ȫ
-            const std::string& p=g_panoFaces[pidx];
-            std::ifstream f(p);
-            if(f.good()) { f.close();doLoadAndEnqueue(p,pidx,0);}
-        }
-        else if(bidx>=0) {
-            //ط
-            std::string found;
-            for(auto& d : g_blockSearchDirs) {
-                std::string p=d+g_blockNames[bidx];
-                std::ifstream f(p);
-                if(f.good()) {
-                    f.close();
-                    found=p;
-                    break;
-                }
-            }
-            if(!found.empty()) doLoadAndEnqueue(found,bidx,1);
-        }
-        else {
-            //󣬶
-            std::this_thread::sleep_for(std::chrono::milliseconds(8));
-        }
-    }
-}
-
-void startTextureLoader() {
-    if(g_loaderRunning) return;
-    g_loaderRunning=true;
-    g_loaderThread=new std::thread(loaderThreadMain);
-    static bool atexitRegistered=false;
-    if(!atexitRegistered) {
-        std::atexit(stopTextureLoader);
-        atexitRegistered=true;
-    }
-}
-
-void stopTextureLoader() {
-    if(!g_loaderRunning) return;
-    g_loaderRunning=false;
-    if(g_loaderThread) {
-        if(g_loaderThread->joinable()) g_loaderThread->join();
-        delete g_loaderThread;g_loaderThread=nullptr;
-    }
-}
-
-void processPendingTextureUploads(int maxUploads) {
-    int count=0;
-    while (count<maxUploads) {
-        PendingImage img;
-        {
-            std::lock_guard<std::mutex> lk(g_pendingMutex);
-            if(g_pendingUploads.empty()) break;
-            img=std::move(g_pendingUploads.front());
-            g_pendingUploads.pop();
-        }
-        GLenum format=(img.channels==4) ? GL_RGBA : GL_RGB;
-        GLuint tex=0;
-        if(img.imageType==1) tex=blockTextures[img.texIndex];
-        else if(img.imageType==2) tex=titleTexture;
-        else if(img.imageType==3) tex=subtitleTexture;
-        else if(img.imageType==4) tex=sphereTexture;
-        else tex=panoramaTextures[img.texIndex];
-        //Ŀδ(==0)ŶӲֹͣ
-        if(tex==0) {
-            std::lock_guard<std::mutex> lk(g_pendingMutex);
-            g_pendingUploads.push(std::move(img));
-            break;
-        }
-        glBindTexture(GL_TEXTURE_2D,tex);
-        glPixelStorei(GL_UNPACK_ALIGNMENT,1);
-        glTexImage2D(GL_TEXTURE_2D,0,format,img.width,img.height,0,format,GL_UNSIGNED_BYTE,img.data.data());
-
-        //
-        if(img.imageType==1) {
-            //ڹ
-            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_REPEAT);
-        }
-        else {
-            //ȫ//⣺Թ
-            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
-        }
-        count++;
-    }
-}
-
-bool hasPendingTextureUploads() {
-    std::lock_guard<std::mutex> lk(g_pendingMutex);
-    return !g_pendingUploads.empty();
-}
-
-//ͳͬ
-void loadBlockTextures() {
-    glGenTextures(NUM_BLOCK_TEXTURES,blockTextures);
-    for(int i=0;i<NUM_BLOCK_TEXTURES;++i) {
-        glBindTexture(GL_TEXTURE_2D,blockTextures[i]);
-        std::string found;
-        for(auto& d : g_blockSearchDirs) {
-            std::string p=d+g_blockNames[i];
-            std::ifstream f(p);
-            if(f.good()) { 
-                f.close();
-                found=p;
-                break;
-            }
-        }
-        if(!found.empty()){
-            int w=0,h=0,c=0;unsigned char* data=SOIL_load_image(found.c_str(),&w,&h,&c,SOIL_LOAD_AUTO);
-            if(data) {
-                int rowSize=w*c;
-                for(int y=0;y<h/2;++y) { 
-                    unsigned char* top=data+y*rowSize;
-                    unsigned char* bot=data+(h-1-y)*rowSize;
-                    for(int x=0;x<rowSize;++x) 
-                        std::swap(top[x],bot[x]);
-                }
-                GLenum format=(c==4) ? GL_RGBA : GL_RGB;glPixelStorei(GL_UNPACK_ALIGNMENT,1);
-                glTexImage2D(GL_TEXTURE_2D,0,format,w,h,0,format,GL_UNSIGNED_BYTE,data);
-                SOIL_free_image_data(data);
-            }else{ 
-                unsigned char pink[3]={ 255,0,255 };
-                glTexImage2D(GL_TEXTURE_2D,0,GL_RGB,1,1,0,GL_RGB,GL_UNSIGNED_BYTE,pink);
-            }
-        }else{ 
-            unsigned char pink[3]={ 255,0,255 };
-            glTexImage2D(GL_TEXTURE_2D,0,GL_RGB,1,1,0,GL_RGB,GL_UNSIGNED_BYTE,pink);
-        }
-
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_NEAREST);
-    }
-}
-
-void loadPanoramaTextures() {
-    glGenTextures(PANORAMA_COUNT,panoramaTextures);
-    for(int i=0;i<PANORAMA_COUNT;++i) {
-        glBindTexture(GL_TEXTURE_2D,panoramaTextures[i]);
-        std::string p=g_panoFaces[i];std::ifstream f(p);
-        if(!f.good()) { 
-            unsigned char pink[3]={ 255,0,255 };
-            glTexImage2D(GL_TEXTURE_2D,0,GL_RGB,1,1,0,GL_RGB,GL_UNSIGNED_BYTE,pink);
-            continue;
-        }
-        f.close();
-        int w=0,h=0,c=0;
-        unsigned char* data=SOIL_load_image(p.c_str(),&w,&h,&c,SOIL_LOAD_AUTO);
-        if(data) { 
-            int rowSize=w*c;
-            for(int y=0;y<h/2;++y) { 
-                unsigned char* top=data+y*rowSize;
-                unsigned char* bot=data+(h-1-y)*rowSize;
-                for(int x=0;x<rowSize;++x) 
-                    std::swap(top[x],bot[x]);
-            } GLenum format=(c==4) ? GL_RGBA : GL_RGB;glPixelStorei(GL_UNPACK_ALIGNMENT,1);
-            glTexImage2D(GL_TEXTURE_2D,0,format,w,h,0,format,GL_UNSIGNED_BYTE,data);
-            SOIL_free_image_data(data);
-        }else{
-            unsigned char pink[3]={ 255,0,255 };
-            glTexImage2D(GL_TEXTURE_2D,0,GL_RGB,1,1,0,GL_RGB,GL_UNSIGNED_BYTE,pink);
-        }
-
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
-    }
-}
-
-void initPanoramaTextureHandles() {
-    glGenTextures(PANORAMA_COUNT,panoramaTextures);
-    unsigned char gray[3]={ 150,150,150 };
-    for(int i=0;i<PANORAMA_COUNT;++i) {
-        glBindTexture(GL_TEXTURE_2D,panoramaTextures[i]);
-        glTexImage2D(GL_TEXTURE_2D,0,GL_RGB,1,1,0,GL_RGB,GL_UNSIGNED_BYTE,gray);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
-    }
-}
-
-void initBlockTextureHandles() {
-    glGenTextures(NUM_BLOCK_TEXTURES,blockTextures);
-    unsigned char gray[3]={ 180,180,180 };
-    for(int i=0;i<NUM_BLOCK_TEXTURES;++i) {
-        glBindTexture(GL_TEXTURE_2D,blockTextures[i]);
-        glTexImage2D(GL_TEXTURE_2D,0,GL_RGB,1,1,0,GL_RGB,GL_UNSIGNED_BYTE,gray);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_REPEAT);
-    }
-}
-
-void initSphereTextureHandle() {
-    glGenTextures(1,&sphereTexture);
-    unsigned char gray[3]={ 200,200,200 };
-    glBindTexture(GL_TEXTURE_2D,sphereTexture);
-    glTexImage2D(GL_TEXTURE_2D,0,GL_RGB,1,1,0,GL_RGB,GL_UNSIGNED_BYTE,gray);
-    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_REPEAT);
-}
-
-void initTitleTextureHandle() {
-    glGenTextures(1,&titleTexture);
-    glBindTexture(GL_TEXTURE_2D,titleTexture);
-    unsigned char transparent[4]={ 0,0,0,0 };
-    glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA,1,1,0,GL_RGBA,GL_UNSIGNED_BYTE,transparent);
-    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
-}
-
-void initSubtitleTextureHandle() {
-    glGenTextures(1,&subtitleTexture);
-    glBindTexture(GL_TEXTURE_2D,subtitleTexture);
-    unsigned char transparent[4]={ 0,0,0,0 };
-    glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA,1,1,0,GL_RGBA,GL_UNSIGNED_BYTE,transparent);
-    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
-}
-
-bool loadPanoramaTextureIndex(int index) {
-    if(index<0 || index>=PANORAMA_COUNT) return false;
-    std::string p=g_panoFaces[index];std::ifstream f(p);
-    if(!f.good()) return false;f.close();int w=0,h=0,c=0;
-    unsigned char* data=SOIL_load_image(p.c_str(),&w,&h,&c,SOIL_LOAD_AUTO);
-    if(!data) return false;
-    PendingImage img;
-    img.texIndex=index;
-    img.imageType=0;
-    img.width=w;
-    img.height=h;
-    img.channels=c;
-    img.data.assign(data,data+(w*h*c));
-    int rowSize=w*c;
-    for(int y=0;y<h/2;++y) { 
-        unsigned char* top=img.data.data()+y*rowSize;
-        unsigned char* bot=img.data.data()+(h-1-y)*rowSize;
-        for(int x=0;x<rowSize;++x) std::swap(top[x],bot[x]);
-    } SOIL_free_image_data(data);
-    enqueuePendingUpload(std::move(img));
-    return true;
-}
-
-bool loadBlockTextureIndex(int index) {
-    if(index<0 || index>=NUM_BLOCK_TEXTURES) return false;
-    std::string found;
-    for(auto& d : g_blockSearchDirs) { 
-        std::string p=d+g_blockNames[index];
-        std::ifstream f(p);
-        if(f.good()) {
-            f.close();
-            found=p;
-            break;
-        } 
-    }
-    if(found.empty()) return false;
-    int w=0,h=0,c=0;
-    unsigned char* data=SOIL_load_image(found.c_str(),&w,&h,&c,SOIL_LOAD_AUTO);
-    if(!data) return false;
-    PendingImage img;
-    img.texIndex=index;
-    img.imageType=1;
-    img.width=w;
-    img.height=h;
-    img.channels=c;
-    img.data.assign(data,data+(w*h*c));
-    int rowSize=w*c;
-    for(int y=0;y<h/2;++y) {
-        unsigned char* top=img.data.data()+y*rowSize;
-        unsigned char* bot=img.data.data()+(h-1-y)*rowSize;
-        for(int x=0;x<rowSize;++x) 
-            std::swap(top[x],bot[x]);
-    } SOIL_free_image_data(data);
-    enqueuePendingUpload(std::move(img));
-    return true;
-}
+#include "../include/Common.h"
+#include "../include/Texture.h"
+#include "../include/JobSystem.h"
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <queue>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+
+//前向声明
+void stopTextureLoader();
+
+//常量
+constexpr int PANORAMA_COUNT=6;
+
+//文件列表
+static const std::vector<std::string> g_panoFaces={
+    "minecraft_textures/gui/title/background/panorama_0.png",
+    "minecraft_textures/gui/title/background/panorama_1.png",
+    "minecraft_textures/gui/title/background/panorama_2.png",
+    "minecraft_textures/gui/title/background/panorama_3.png",
+    "minecraft_textures/gui/title/background/panorama_4.png",
+    "minecraft_textures/gui/title/background/panorama_5.png"
+};
+
+static const std::string g_titleTexturePath="minecraft_textures/gui/title/yourscraft.png";
+static const std::string g_subtitleTexturePath="minecraft_textures/gui/title/yourcraft_ch.png";
+
+static const std::vector<std::string> g_blockNames={
+    "grass_top.png",
+    "dirt.png",
+    "stone.png",
+    "planks_oak.png",
+    "leaves_oak.png",
+    "sand.png",
+    "water.png",
+    "grass_side.png",
+    "cloud.png"
+};
+
+static const std::string g_sphereTextureName="soccer.png";
+
+static const std::vector<std::string> g_blockSearchDirs={
+    "minecraft_textures/blocks/",
+    "minecraft_textures/"
+    ""
+};
+
+//待上传图片数据结构
+struct PendingImage {
+    int texIndex=-1;
+    int imageType=0;//0 -> panoramaTextures[],1 -> blockTextures[],2 -> titleTexture,3 -> subtitleTexture,4 -> sphereTexture
+    std::vector<unsigned char> data;
+    int width=0,height=0,channels=0;
+};
+
+//异步加载：解码请求按优先级排队，任务系统中的执行令牌每次取优先级最高的请求，解码结果排队等待主线程上传
+static std::queue<PendingImage> g_pendingUploads;
+static std::mutex g_pendingMutex;
+
+//解码优先级：全景贴图（启动画面）> 方块纹理 > 标题/副标题/球体
+enum DecodePriority { DECODE_PANORAMA=0,DECODE_BLOCK=1,DECODE_SPECIAL=2,DECODE_PRIORITY_COUNT=3 };
+static std::queue<std::function<void()>> g_decodeRequests[DECODE_PRIORITY_COUNT];
+static std::mutex g_requestMutex;
+
+static std::atomic<bool> g_loaderStopping{ false };
+static std::atomic<int> g_pendingDecodes{ 0 };
+
+static void enqueuePendingUpload(PendingImage&& img) {
+    std::lock_guard<std::mutex> lk(g_pendingMutex);
+    g_pendingUploads.push(std::move(img));
+}
+
+//提交一个解码请求；令牌执行时才出队，与地形/网格任务混排时仍按优先级先解码全景；stopTextureLoader 之后请求不再执行
+static void submitDecode(DecodePriority priority,std::function<void()> decode) {
+    ++g_pendingDecodes;
+    {
+        std::lock_guard<std::mutex> lk(g_requestMutex);
+        g_decodeRequests[priority].push(std::move(decode));
+    }
+    getJobSystem().submit([]() {
+        std::function<void()> next;
+        {
+            std::lock_guard<std::mutex> lk(g_requestMutex);
+            for(auto &q : g_decodeRequests) {
+                if(q.empty()) continue;
+                next=std::move(q.front());
+                q.pop();
+                break;
+            }
+        }
+        if(next && !g_loaderStopping) next();
+        --g_pendingDecodes;
+    });
+}
+
+//按搜索目录查找存在的文件，找不到返回空串
+static std::string findInSearchDirs(const std::string& name) {
+    for(auto &d : g_blockSearchDirs) {
+        std::string p=d+name;
+        std::ifstream f(p);
+        if(f.good()) return p;
+    }
+    return std::string();
+}
+
+static bool fileExists(const std::string& path) {
+    std::ifstream f(path);
+    return f.good();
+}
+
+static void doLoadAndEnqueue(const std::string& path,int texIndex,int imageType) {
+    int w=0,h=0,c=0;
+    unsigned char* data=SOIL_load_image(path.c_str(),&w,&h,&c,SOIL_LOAD_AUTO);
+    if(!data) { std::cerr << "SOIL failed to load: " << path << "\n";return;}
+    PendingImage img;
+    img.texIndex=texIndex;
+    img.imageType=imageType;
+    img.width=w;img.height=h;img.channels=c;
+    img.data.assign(data,data+(w*h*c));
+    //垂直翻转
+    int rowSize=w*c;
+    for(int y=0;y<h/2;++y) {
+        unsigned char* top=img.data.data()+y*rowSize;
+        unsigned char* bot=img.data.data()+(h-1-y)*rowSize;
+        for(int x=0;x<rowSize;++x) std::swap(top[x],bot[x]);
+    }
+    SOIL_free_image_data(data);
+    enqueuePendingUpload(std::move(img));
+}
+
+void requestPanoramaLoad(int index) {
+    if(index<0 || index>=(int)g_panoFaces.size()) return;
+    submitDecode(DECODE_PANORAMA,[index]() {
+        const std::string& p=g_panoFaces[index];
+        if(fileExists(p)) doLoadAndEnqueue(p,index,0);
+    });
+}
+
+void requestBlockTextureLoad(int index) {
+    if(index<0 || index>=(int)g_blockNames.size()) return;
+    submitDecode(DECODE_BLOCK,[index]() {
+        std::string found=findInSearchDirs(g_blockNames[index]);
+        if(!found.empty()) doLoadAndEnqueue(found,index,1);
+    });
+}
+
+void requestTitleTextureLoad() {
+    submitDecode(DECODE_SPECIAL,[]() {
+        if(fileExists(g_titleTexturePath)) doLoadAndEnqueue(g_titleTexturePath,0,2);
+    });
+}
+
+void requestSubtitleTextureLoad() {
+    submitDecode(DECODE_SPECIAL,[]() {
+        if(fileExists(g_subtitleTexturePath)) doLoadAndEnqueue(g_subtitleTexturePath,0,3);
+    });
+}
+
+void requestSphereTextureLoad() {
+    submitDecode(DECODE_SPECIAL,[]() {
+        std::string found=findInSearchDirs(g_sphereTextureName);
+        if(!found.empty()) doLoadAndEnqueue(found,0,4);
+    });
+}
+
+void startTextureLoader() {
+    //先创建任务系统，保证其晚于 atexit 注册的 stopTextureLoader 销毁
+    getJobSystem();
+    g_loaderStopping=false;
+    static bool atexitRegistered=false;
+    if(!atexitRegistered) {
+        std::atexit(stopTextureLoader);
+        atexitRegistered=true;
+    }
+}
+
+void stopTextureLoader() {
+    //已排队的解码任务直接返回，等待它们全部结束
+    g_loaderStopping=true;
+    while (g_pendingDecodes.load()>0) std::this_thread::yield();
+}
+
+void processPendingTextureUploads(int maxUploads) {
+    FrameSlice slice(maxUploads);
+    processPendingTextureUploads(slice);
+}
+
+int processPendingTextureUploads(FrameSlice &slice) {
+    for(;;) {
+        PendingImage img;
+        double kb;
+        {
+            std::lock_guard<std::mutex> lk(g_pendingMutex);
+            if(g_pendingUploads.empty()) break;
+            kb=g_pendingUploads.front().data.size()/1024.0;
+            if(!slice.more(kb)) break;
+            img=std::move(g_pendingUploads.front());
+            g_pendingUploads.pop();
+        }
+        GLenum format=(img.channels==4) ? GL_RGBA : GL_RGB;
+        GLuint tex=0;
+        if(img.imageType==1) tex=blockTextures[img.texIndex];
+        else if(img.imageType==2) tex=titleTexture;
+        else if(img.imageType==3) tex=subtitleTexture;
+        else if(img.imageType==4) tex=sphereTexture;
+        else tex=panoramaTextures[img.texIndex];
+        //如果目标纹理句柄尚未创建(==0)，重新排队并停止
+        if(tex==0) {
+            std::lock_guard<std::mutex> lk(g_pendingMutex);
+            g_pendingUploads.push(std::move(img));
+            break;
+        }
+        glBindTexture(GL_TEXTURE_2D,tex);
+        glPixelStorei(GL_UNPACK_ALIGNMENT,1);
+        glTexImage2D(GL_TEXTURE_2D,0,format,img.width,img.height,0,format,GL_UNSIGNED_BYTE,img.data.data());
+
+        //根据类型设置纹理参数
+        if(img.imageType==1) {
+            //方块纹理：最近邻过滤
+            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_REPEAT);
+        }
+        else {
+            //全景/标题/副标题：线性过滤
+            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
+        }
+        slice.done(kb);
+    }
+    return slice.getUnits();
+}
+
+bool hasPendingTextureUploads() {
+    if(g_pendingDecodes.load()>0) return true;
+    std::lock_guard<std::mutex> lk(g_pendingMutex);
+    return !g_pendingUploads.empty();
+}
+
+//传统同步加载器
+void loadBlockTextures() {
+    glGenTextures(NUM_BLOCK_TEXTURES,blockTextures);
+    for(int i=0;i<NUM_BLOCK_TEXTURES;++i) {
+        glBindTexture(GL_TEXTURE_2D,blockTextures[i]);
+        std::string found;
+        for(auto& d : g_blockSearchDirs) {
+            std::string p=d+g_blockNames[i];
+            std::ifstream f(p);
+            if(f.good()) { 
+                f.close();
+                found=p;
+                break;
+            }
+        }
+        if(!found.empty()){
+            int w=0,h=0,c=0;unsigned char* data=SOIL_load_image(found.c_str(),&w,&h,&c,SOIL_LOAD_AUTO);
+            if(data) {
+                int rowSize=w*c;
+                for(int y=0;y<h/2;++y) { 
+                    unsigned char* top=data+y*rowSize;
+                    unsigned char* bot=data+(h-1-y)*rowSize;
+                    for(int x=0;x<rowSize;++x) 
+                        std::swap(top[x],bot[x]);
+                }
+                GLenum format=(c==4) ? GL_RGBA : GL_RGB;glPixelStorei(GL_UNPACK_ALIGNMENT,1);
+                glTexImage2D(GL_TEXTURE_2D,0,format,w,h,0,format,GL_UNSIGNED_BYTE,data);
+                SOIL_free_image_data(data);
+            }else{ 
+                unsigned char pink[3]={ 255,0,255 };
+                glTexImage2D(GL_TEXTURE_2D,0,GL_RGB,1,1,0,GL_RGB,GL_UNSIGNED_BYTE,pink);
+            }
+        }else{ 
+            unsigned char pink[3]={ 255,0,255 };
+            glTexImage2D(GL_TEXTURE_2D,0,GL_RGB,1,1,0,GL_RGB,GL_UNSIGNED_BYTE,pink);
+        }
+
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_NEAREST);
+    }
+}
+
+void loadPanoramaTextures() {
+    glGenTextures(PANORAMA_COUNT,panoramaTextures);
+    for(int i=0;i<PANORAMA_COUNT;++i) {
+        glBindTexture(GL_TEXTURE_2D,panoramaTextures[i]);
+        std::string p=g_panoFaces[i];std::ifstream f(p);
+        if(!f.good()) { 
+            unsigned char pink[3]={ 255,0,255 };
+            glTexImage2D(GL_TEXTURE_2D,0,GL_RGB,1,1,0,GL_RGB,GL_UNSIGNED_BYTE,pink);
+            continue;
+        }
+        f.close();
+        int w=0,h=0,c=0;
+        unsigned char* data=SOIL_load_image(p.c_str(),&w,&h,&c,SOIL_LOAD_AUTO);
+        if(data) { 
+            int rowSize=w*c;
+            for(int y=0;y<h/2;++y) { 
+                unsigned char* top=data+y*rowSize;
+                unsigned char* bot=data+(h-1-y)*rowSize;
+                for(int x=0;x<rowSize;++x) 
+                    std::swap(top[x],bot[x]);
+            } GLenum format=(c==4) ? GL_RGBA : GL_RGB;glPixelStorei(GL_UNPACK_ALIGNMENT,1);
+            glTexImage2D(GL_TEXTURE_2D,0,format,w,h,0,format,GL_UNSIGNED_BYTE,data);
+            SOIL_free_image_data(data);
+        }else{
+            unsigned char pink[3]={ 255,0,255 };
+            glTexImage2D(GL_TEXTURE_2D,0,GL_RGB,1,1,0,GL_RGB,GL_UNSIGNED_BYTE,pink);
+        }
+
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
+    }
+}
+
+void initPanoramaTextureHandles() {
+    glGenTextures(PANORAMA_COUNT,panoramaTextures);
+    unsigned char gray[3]={ 150,150,150 };
+    for(int i=0;i<PANORAMA_COUNT;++i) {
+        glBindTexture(GL_TEXTURE_2D,panoramaTextures[i]);
+        glTexImage2D(GL_TEXTURE_2D,0,GL_RGB,1,1,0,GL_RGB,GL_UNSIGNED_BYTE,gray);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
+    }
+}
+
+void initBlockTextureHandles() {
+    glGenTextures(NUM_BLOCK_TEXTURES,blockTextures);
+    unsigned char gray[3]={ 180,180,180 };
+    for(int i=0;i<NUM_BLOCK_TEXTURES;++i) {
+        glBindTexture(GL_TEXTURE_2D,blockTextures[i]);
+        glTexImage2D(GL_TEXTURE_2D,0,GL_RGB,1,1,0,GL_RGB,GL_UNSIGNED_BYTE,gray);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_REPEAT);
+    }
+}
+
+void initSphereTextureHandle() {
+    glGenTextures(1,&sphereTexture);
+    unsigned char gray[3]={ 200,200,200 };
+    glBindTexture(GL_TEXTURE_2D,sphereTexture);
+    glTexImage2D(GL_TEXTURE_2D,0,GL_RGB,1,1,0,GL_RGB,GL_UNSIGNED_BYTE,gray);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_REPEAT);
+}
+
+void initTitleTextureHandle() {
+    glGenTextures(1,&titleTexture);
+    glBindTexture(GL_TEXTURE_2D,titleTexture);
+    unsigned char transparent[4]={ 0,0,0,0 };
+    glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA,1,1,0,GL_RGBA,GL_UNSIGNED_BYTE,transparent);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
+}
+
+void initSubtitleTextureHandle() {
+    glGenTextures(1,&subtitleTexture);
+    glBindTexture(GL_TEXTURE_2D,subtitleTexture);
+    unsigned char transparent[4]={ 0,0,0,0 };
+    glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA,1,1,0,GL_RGBA,GL_UNSIGNED_BYTE,transparent);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
+}
+
+bool loadPanoramaTextureIndex(int index) {
+    if(index<0 || index>=PANORAMA_COUNT) return false;
+    std::string p=g_panoFaces[index];std::ifstream f(p);
+    if(!f.good()) return false;f.close();int w=0,h=0,c=0;
+    unsigned char* data=SOIL_load_image(p.c_str(),&w,&h,&c,SOIL_LOAD_AUTO);
+    if(!data) return false;
+    PendingImage img;
+    img.texIndex=index;
+    img.imageType=0;
+    img.width=w;
+    img.height=h;
+    img.channels=c;
+    img.data.assign(data,data+(w*h*c));
+    int rowSize=w*c;
+    for(int y=0;y<h/2;++y) { 
+        unsigned char* top=img.data.data()+y*rowSize;
+        unsigned char* bot=img.data.data()+(h-1-y)*rowSize;
+        for(int x=0;x<rowSize;++x) std::swap(top[x],bot[x]);
+    } SOIL_free_image_data(data);
+    enqueuePendingUpload(std::move(img));
+    return true;
+}
+
+bool loadBlockTextureIndex(int index) {
+    if(index<0 || index>=NUM_BLOCK_TEXTURES) return false;
+    std::string found;
+    for(auto& d : g_blockSearchDirs) { 
+        std::string p=d+g_blockNames[index];
+        std::ifstream f(p);
+        if(f.good()) {
+            f.close();
+            found=p;
+            break;
+        } 
+    }
+    if(found.empty()) return false;
+    int w=0,h=0,c=0;
+    unsigned char* data=SOIL_load_image(found.c_str(),&w,&h,&c,SOIL_LOAD_AUTO);
+    if(!data) return false;
+    PendingImage img;
+    img.texIndex=index;
+    img.imageType=1;
+    img.width=w;
+    img.height=h;
+    img.channels=c;
+    img.data.assign(data,data+(w*h*c));
+    int rowSize=w*c;
+    for(int y=0;y<h/2;++y) {
+        unsigned char* top=img.data.data()+y*rowSize;
+        unsigned char* bot=img.data.data()+(h-1-y)*rowSize;
+        for(int x=0;x<rowSize;++x) 
+            std::swap(top[x],bot[x]);
+    } SOIL_free_image_data(data);
+    enqueuePendingUpload(std::move(img));
+    return true;
+}
@@ -1,520 +1,1363 @@
-#include "../include/World.h"
-#include "../include/Shader.h"
-#include <iostream>
-#include <algorithm>
-
-World::World() : renderDistance(10) {
-    //߳
-    workerRunning=true;
-    unsigned int threadCount=std::max(1u,std::thread::hardware_concurrency()>1 ? std::thread::hardware_concurrency()-1 : 1);
-    for(unsigned int i=0;i<threadCount;++i) {
-        workers.emplace_back([this]() {
-            while (workerRunning) {
-                Chunk* terrainChunk=nullptr;
-                BuildRequest req;
-                bool haveTerrain=false;
-                {
-                    std::unique_lock<std::mutex> lk(buildMutex);
-                    buildCv.wait(lk,[this]{ return !terrainQueue.empty() || !buildQueue.empty() || !workerRunning;});
-                    if(!workerRunning) return;
-                    if(!terrainQueue.empty()) { 
-                        terrainChunk=terrainQueue.front();
-                        terrainQueue.pop();
-                        haveTerrain=true;
-                    }else if(!buildQueue.empty()) {
-                        req=buildQueue.front();
-                        buildQueue.pop();
-                    }
-                }
-
-                if(haveTerrain && terrainChunk) {
-                    //ڹ߳ɵ
-                    terrainChunk->generateTerrain();
-                    //ɺ󴴽
-                    MeshData data=terrainChunk->buildMeshCPU(nullptr,nullptr);//full 6 
-                    {
-                        std::lock_guard<std::mutex> ul(uploadMutex);
-                        uploadQueue.push(std::move(data));
-                    }
-                    continue;
-                }
-
-                if(!req.chunk) continue;
-                //ڹ̹߳ݣ CPU
-                const glm::vec3* v=req.full ? nullptr : &req.viewDir;
-                const glm::vec3* l=req.full ? nullptr : &req.lightDir;
-                MeshData data=req.chunk->buildMeshCPU(v,l);
-
-                //ϴ
-                {
-                    std::lock_guard<std::mutex> ul(uploadMutex);
-                    uploadQueue.push(std::move(data));
-                }
-            }
-        });
-    }
-}
-
-World::~World(){ 
-    //ֹͣ߳
-    workerRunning=false;
-    buildCv.notify_all();
-    for(auto &t : workers) 
-        if(t.joinable()) t.join();
-
-    //ɾ chunks
-    for(auto &p: chunks) 
-        delete p.second;
-}
-
-Chunk* World::getChunk(int chunkX,int chunkZ){ 
-    auto key=std::make_pair(chunkX,chunkZ);
-    if(chunks.find(key)==chunks.end()){ 
-        Chunk* c=new Chunk(chunkX,chunkZ);
-        // worker 
-        {
-            std::lock_guard<std::mutex> lk(buildMutex);
-            terrainQueue.push(c);
-            chunks[key]=c;
-        }
-        buildCv.notify_one();
-        return c;
-    } 
-    return chunks[key];
-}
-
-BlockType World::getBlock(int x,int y,int z){ 
-    int chunkX=x>=0? x/CHUNK_SIZE : (x-CHUNK_SIZE+1)/CHUNK_SIZE;
-    int chunkZ=z>=0? z/CHUNK_SIZE : (z-CHUNK_SIZE+1)/CHUNK_SIZE;
-    int localX=x-chunkX*CHUNK_SIZE;
-    int localZ=z-chunkZ*CHUNK_SIZE;
-    Chunk* c=getChunk(chunkX,chunkZ);
-    return c->getBlock(localX,y,localZ);
-}
-
-//ȡڵ blockȱʧ chunkδط AIR
-BlockType World::getBlockIfLoaded(int x,int y,int z) {
-    int chunkX=x>=0? x/CHUNK_SIZE : (x-CHUNK_SIZE+1)/CHUNK_SIZE;
-    int chunkZ=z>=0? z/CHUNK_SIZE : (z-CHUNK_SIZE+1)/CHUNK_SIZE;
-    int localX=x-chunkX*CHUNK_SIZE;
-    int localZ=z-chunkZ*CHUNK_SIZE;
-    std::lock_guard<std::mutex> lk(buildMutex);
-    auto it=chunks.find({chunkX,chunkZ});
-    if(it==chunks.end()) return AIR;
-    Chunk* c=it->second;
-    return c->getBlock(localX,y,localZ);
-}
-
-bool World::hasChunkLoaded(int chunkX,int chunkZ) const {
-    std::lock_guard<std::mutex> lk(const_cast<std::mutex&>(buildMutex));
-    return chunks.find({chunkX,chunkZ})!=chunks.end();
-}
-
-void World::setBlock(int x,int y,int z,BlockType type){ 
-    int chunkX=x>=0? x/CHUNK_SIZE : (x-CHUNK_SIZE+1)/CHUNK_SIZE;
-    int chunkZ=z>=0? z/CHUNK_SIZE : (z-CHUNK_SIZE+1)/CHUNK_SIZE;
-    int localX=x-chunkX*CHUNK_SIZE;
-    int localZ=z-chunkZ*CHUNK_SIZE;
-    Chunk* c=getChunk(chunkX,chunkZ);
-    c->setBlock(localX,y,localZ,type);
-
-    //ھӣ߽磩Աؽ
-    const int lx=localX,ly=y,lz=localZ;
-    auto tryMarkNeighbor=[&](int nx,int nz){
-        auto it=chunks.find({nx,nz});
-        if(it!=chunks.end()) it->second->setNeedsMeshUpdate(true);
-    };
-    if(lx==0) tryMarkNeighbor(chunkX-1,chunkZ);
-    if(lx==CHUNK_SIZE-1) tryMarkNeighbor(chunkX+1,chunkZ);
-    if(lz==0) tryMarkNeighbor(chunkX,chunkZ-1);
-    if(lz==CHUNK_SIZE-1) tryMarkNeighbor(chunkX,chunkZ+1);
-
-    //߳ؽ chunk 񣬱֤༭ʱɼ
-    //ͬʱؽǵھ chunk
-    //עgetChunk() ܴ chunkȷ chunk  map ʱؽ
-    if(c) {
-        c->buildMesh(nullptr,nullptr);
-        c->setPendingBuild(false);
-    }
-    //ͬؽھӣڣ
-    if(lx==0) { auto it=chunks.find({chunkX-1,chunkZ});
-        if(it!=chunks.end()) { 
-            it->second->buildMesh(nullptr,nullptr);
-            it->second->setPendingBuild(false);
-        } 
-    }
-    if(lx==CHUNK_SIZE-1) { 
-        auto it=chunks.find({chunkX+1,chunkZ});
-        if(it!=chunks.end()) { 
-            it->second->buildMesh(nullptr,nullptr);
-            it->second->setPendingBuild(false);
-        }
-    }
-    if(lz==0) { 
-        auto it=chunks.find({chunkX,chunkZ-1});
-        if(it!=chunks.end()) { 
-            it->second->buildMesh(nullptr,nullptr);
-            it->second->setPendingBuild(false);
-        }
-    }
-    if(lz==CHUNK_SIZE-1) {
-        auto it=chunks.find({chunkX,chunkZ+1});
-        if(it!=chunks.end()) { 
-            it->second->buildMesh(nullptr,nullptr);
-            it->second->setPendingBuild(false);
-        } 
-    }
-
-    // worker Էڵȴ
-    buildCv.notify_all();
-}
-
-
-
-void World::updateChunks(const Camera& camera,const glm::vec3& lightDir){ 
-    int playerChunkX=(int)floor(camera.position.x/CHUNK_SIZE);
-    int playerChunkZ=(int)floor(camera.position.z/CHUNK_SIZE);
-    int createdThisFrame=0;
-    for(int x=-renderDistance;x<=renderDistance;++x) {
-        for(int z=-renderDistance;z<=renderDistance;++z) {
-            if(x*x+z*z>renderDistance*renderDistance) continue;
-            //ÿ֡½ chunk 
-            auto key=std::make_pair(playerChunkX+x,playerChunkZ+z);
-            {
-                std::lock_guard<std::mutex> lk(buildMutex);
-                if(chunks.find(key)!=chunks.end()) continue;
-            }
-            if(createdThisFrame<maxNewChunksPerFrame) {
-                getChunk(playerChunkX+x,playerChunkZ+z);
-                ++createdThisFrame;
-            }
-            //ﵽƺ֡
-        }
-    }
-    
-    //ΪҪδڶе chunk ύ
-    std::vector<BuildRequest> toSubmit;
-    glm::vec3 viewDir=camera.front;
-
-    for(auto &p : chunks) {
-        Chunk* c=p.second;
-        if(c->needsMeshUpdate() && !c->isPendingBuild()) {
-            c->setPendingBuild(true);
-            BuildRequest req;
-            req.chunk=c;
-            req.viewDir=viewDir;
-            req.lightDir=lightDir;
-            // chunk ޸ʱִؽͼصѡؽ
-            req.full=c->needsMeshUpdate();
-            toSubmit.push_back(req);
-        }
-    }
-
-    if(!toSubmit.empty()) {
-        std::lock_guard<std::mutex> lk(buildMutex);
-        for(auto &r : toSubmit) buildQueue.push(r);
-        buildCv.notify_all();
-    }
-
-    //Զ chunk ͷ GPU Դ
-    int evictionRadius=renderDistance+5;
-    std::vector<std::pair<int,int>> candidates;
-    for(auto &kv : chunks) candidates.push_back(kv.first);
-
-    for(auto &key : candidates) {
-        int cx=key.first;
-        int cz=key.second;
-        int dx=std::abs(cx-playerChunkX);
-        int dz=std::abs(cz-playerChunkZ);
-        if(std::max(dx,dz)<=evictionRadius) continue;//Ȼ㹻
-
-        Chunk* chunkPtr=nullptr;
-        auto itChunk=chunks.find(key);
-        if(itChunk==chunks.end()) continue;
-        chunkPtr=itChunk->second;
-
-        //ڼ
-        bool referenced=false;
-        {
-            std::lock_guard<std::mutex> lk(buildMutex);
-            // terrainQueue
-            std::queue<Chunk*> terrainCopy=terrainQueue;
-            while (!terrainCopy.empty()) { 
-                if(terrainCopy.front()==chunkPtr) { 
-                    referenced=true;
-                    break;
-                } 
-                terrainCopy.pop();
-            }
-
-            // buildQueue
-            if(!referenced) {
-                std::queue<BuildRequest> buildCopy=buildQueue;
-                while (!buildCopy.empty()) { 
-                    if(buildCopy.front().chunk==chunkPtr) {
-                        referenced=true;
-                        break;
-                    }
-                    buildCopy.pop();
-                }
-            }
-
-            //Ҳ pendingBuild ־
-            if(!referenced && chunkPtr->isPendingBuild()) referenced=true;
-
-            if(!referenced) {
-                //Ҫ uploadQueue uploadMutex
-                std::lock_guard<std::mutex> ul(uploadMutex);
-                std::queue<MeshData> uploadCopy=uploadQueue;
-                while (!uploadCopy.empty()) { 
-                    if(uploadCopy.front().chunkX==cx && uploadCopy.front().chunkZ==cz) {
-                        referenced=true;
-                        break;
-                    }
-                    uploadCopy.pop();
-                }
-            }
-
-            if(!referenced) {
-                //ȫɾ map ɾ delete chunk GL ̣߳
-                delete chunkPtr;
-                chunks.erase(itChunk);
-                //עChunk::~Chunk ɾ GL Դ GL ִ߳
-            }
-        }
-    }
-
-}
-
-// chunk Ƿ׶ڣ+Ա߽飩
-bool World::isChunkInFrustum(Chunk* chunk,const Camera& camera,const glm::mat4& viewProj) const {
-    int cx=chunk->getChunkX();
-    int cz=chunk->getChunkZ();
-    
-    //Chunk ĵ㣨꣩
-    glm::vec3 chunkCenter(
-        cx*CHUNK_SIZE+CHUNK_SIZE*0.5f,
-        CHUNK_HEIGHT*0.5f,
-        cz*CHUNK_SIZE+CHUNK_SIZE*0.5f
-    );
-    
-    //1. ٱ⣺ chunk Ƿǰ
-    glm::vec3 toChunk=chunkCenter-camera.position;
-    float distanceToChunk=glm::length(toChunk);
-    
-    //̫ҿ chunk ڣȾ
-    if(distanceToChunk<CHUNK_SIZE*1.5f) {
-        return true;
-    }
-    
-    glm::vec3 dirToChunk=toChunk/distanceToChunk;
-    float dotProduct=glm::dot(dirToChunk,camera.front);
-    
-    //Сֵ˵ chunk 󷽻Զ
-    if(dotProduct<-0.5f) {
-        return false;
-    }
-    
-    //2. ׶飺ΧǷ׶ཻ
-    float boundingRadius=glm::length(glm::vec3(CHUNK_SIZE,CHUNK_HEIGHT,CHUNK_SIZE))*0.5f;
-    glm::vec4 clipPos=viewProj*glm::vec4(chunkCenter,1.0f);
-    if(clipPos.w>0.0f) {
-        glm::vec3 ndc=glm::vec3(clipPos)/clipPos.w;
-        float ndcRadius=boundingRadius/clipPos.w*2.0f;//
-        if(ndc.x+ndcRadius<-1.0f || ndc.x-ndcRadius>1.0f ||
-            ndc.y+ndcRadius<-1.0f || ndc.y-ndcRadius>1.0f ||
-            ndc.z+ndcRadius<0.0f || ndc.z-ndcRadius>1.0f) {
-            return false;
-        }
-    }
-    
-    return true;
-}
-
-void World::render(Shader& shader,const Camera& camera,const glm::vec3& lightDir){ 
-    glm::vec3 viewDir=camera.front;//ȡ߷
-    
-    //ϴУÿ֡ϴ
-    int uploadsThisFrame=0;
-    while (uploadsThisFrame<maxUploadsPerFrame) {
-        MeshData data;
-        {
-            std::lock_guard<std::mutex> lk(uploadMutex);
-            if(uploadQueue.empty()) break;
-            data=std::move(uploadQueue.front());uploadQueue.pop();
-        }
-        auto key=std::make_pair(data.chunkX,data.chunkZ);
-        auto it=chunks.find(key);
-        if(it!=chunks.end()) {
-            it->second->uploadMeshFromData(data);
-        }
-        uploadsThisFrame++;
-    }
-
-    // view-projection ׶޳
-    int width=WINDOW_WIDTH,height=WINDOW_HEIGHT;
-    glm::mat4 view=camera.getViewMatrix();
-    glm::mat4 projection=glm::perspective(glm::radians(45.0f),(float)width/(float)height,0.1f,200.0f);
-    glm::mat4 viewProj=projection*view;
-    
-    //ռɼ chunk
-    std::vector<Chunk*> visibleChunks;
-    visibleChunks.reserve(chunks.size());
-    for(auto &p: chunks) {
-        if(!isChunkInFrustum(p.second,camera,viewProj)) continue;
-        visibleChunks.push_back(p.second);
-    }
-
-    //1) ͸ͨȾпɼ chunk Ĳ͸
-    for(Chunk* c : visibleChunks) {
-        c->renderOpaque(shader,&lightDir);
-    }
-
-    //2) ͸ͨռ͸棬ȫԶ
-    std::vector<std::tuple<float,int,int,Chunk*>> transFaces;
-    transFaces.reserve(1024);
-    for(Chunk* c : visibleChunks)
-        c->collectTransparentFaces(transFaces,&viewDir,&camera.position);
-
-    std::sort(transFaces.begin(),transFaces.end(),[](const auto &a,const auto &b){ return std::get<0>(a)>std::get<0>(b);});
-
-    //͸棬ϲд
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
-    glDepthMask(GL_FALSE);
-    shader.setFloat("specularStrength",0.0f);
-    for(auto &t : transFaces) {
-        int texIndex=std::get<1>(t);
-        int faceIdx=std::get<2>(t);
-        Chunk* chunkPtr=std::get<3>(t);
-        chunkPtr->drawTransparentFace(texIndex,faceIdx);
-    }
-    glDepthMask(GL_TRUE);
-    glDisable(GL_BLEND);
-}
-
-//ӹ̴߳ϴ GPU  GL ̵߳ã
-void World::processUploads(int maxUploads) {
-    int uploadsThisFrame=0;
-    while (uploadsThisFrame<maxUploads) {
-        MeshData data;
-        {
-            std::lock_guard<std::mutex> lk(uploadMutex);
-            if(uploadQueue.empty()) break;
-            data=std::move(uploadQueue.front());
-            uploadQueue.pop();
-        }
-        auto key=std::make_pair(data.chunkX,data.chunkZ);
-        auto it=chunks.find(key);
-        if(it!=chunks.end()) {
-            it->second->uploadMeshFromData(data);
-        }
-        uploadsThisFrame++;
-    }
-}
-
-//̨ worker Ƿд
-bool World::hasPendingWork() const {
-    std::lock_guard<std::mutex> lk(const_cast<std::mutex&>(buildMutex));
-    std::lock_guard<std::mutex> ul(const_cast<std::mutex&>(uploadMutex));
-    return !terrainQueue.empty() || !buildQueue.empty() || !uploadQueue.empty();
-}
-int World::getPendingTasksCount() const {
-    std::lock_guard<std::mutex> lk(const_cast<std::mutex&>(buildMutex));
-    std::lock_guard<std::mutex> ul(const_cast<std::mutex&>(uploadMutex));
-    return terrainQueue.size()+buildQueue.size()+uploadQueue.size();
-}
-//ʼɼϴǷ
-bool World::isInitialGenerationComplete() {
-    std::lock_guard<std::mutex> lk(buildMutex);
-    std::lock_guard<std::mutex> ul(uploadMutex);
-    return terrainQueue.empty() && buildQueue.empty() && uploadQueue.empty();
-}
-//ˮģ⣺޵ˮ£ÿһΣ
-void World::simulateWater(const Camera& camera) {
-    static float g_waterAcc=0.0f;
-    float deltaTime=1.0f/60.0f;//ֱʹã
-    g_waterAcc += 1.0f/60.0f;//ƵԼ 60hzۼӣ水봥
-    if(g_waterAcc<1.0f) return;
-    g_waterAcc=fmodf(g_waterAcc,1.0f);
-
-
-    int cx=(int)floor(camera.position.x);
-    int cy=(int)floor(camera.position.y);
-    int cz=(int)floor(camera.position.z);
-    int minX=cx-2*(int)REACH_DISTANCE;
-    int maxX=cx+2*(int)REACH_DISTANCE;
-    int minY=cy-2*(int)REACH_DISTANCE;
-    int maxY=cy+2*(int)REACH_DISTANCE;
-    int minZ=cz-2*(int)REACH_DISTANCE;
-    int maxZ=cz+2*(int)REACH_DISTANCE;
-
-    int processMinY=minY;
-    if(minY>=0) {
-        bool found=false;
-        for(int x=minX;x<=maxX && !found;++x) {
-            for(int z=minZ;z<=maxZ;++z) {
-                if(getBlock(x,minY,z)==WATER) {
-                    found=true;
-                    break;
-                }
-            }
-        }
-        if(found) processMinY=minY-1;
-    }
-    if(processMinY<0) processMinY=0;
-
-    int processMaxY=maxY;
-    {
-        bool foundTop=false;
-        for(int x=minX;x<=maxX && !foundTop;++x) {
-            for(int z=minZ;z<=maxZ;++z) {
-                if(getBlock(x,maxY,z)==WATER) {
-                    foundTop=true;
-                    break;
-                }
-            }
-        }
-        if(foundTop) processMaxY=maxY+1;
-    }
-
-    for(int y=processMinY;y<=processMaxY;++y) {
-        struct Change { int x,y,z;BlockType t;};
-        std::vector<Change> pendingThisLayer;
-        for(int x=minX;x<=maxX;++x) {
-            for(int z=minZ;z<=maxZ;++z) {
-                if(y<0) continue;
-                BlockType bt=getBlock(x,y,z);
-                if(bt!=WATER) continue;
-                if(y-1>=0 && getBlock(x,y-1,z)==AIR) {
-                    setBlock(x,y-1,z,WATER);
-                    pendingThisLayer.push_back({x,y,z,AIR});
-                    continue;
-                }
-                const int dx[4]={1,-1,0,0};
-                const int dz[4]={0,0,1,-1};
-                for(int i=0;i<4;++i) {
-                    int nx=x+dx[i];
-                    int nz=z+dz[i];
-                    char wn=0;
-                    if(getBlock(nx-1,y,nz)==WATER)wn++;
-                    if(getBlock(nx+1,y,nz)==WATER)wn++;
-                    if(getBlock(nx,y,nz-1)==WATER)wn++;
-                    if(getBlock(nx,y,nz+1)==WATER)wn++;
-                    if(wn<4 && getBlock(x,y-1,z)==WATER) continue;
-                    if(nx<minX || nx>maxX || nz<minZ || nz>maxZ) continue;
-                    if(getBlock(nx,y,nz)!=AIR) continue;
-                    BlockType belowTarget=(y-1>=0) ? getBlock(nx,y-1,nz) : WATER;
-                    if(belowTarget!=AIR) {
-                        pendingThisLayer.push_back({nx,y,nz,WATER});
-                    } else {
-                        if(y-1>=0 && getBlock(nx,y-1,nz)==AIR) {
-                            setBlock(nx,y-1,nz,WATER);
-                        }
-                    }
-                }
-            }
-        }
-        for(const auto &c : pendingThisLayer) setBlock(c.x,c.y,c.z,c.t);
-    }
-}
+#include "../include/World.h"
+#include "../include/Shader.h"
+#include "../include/AllocStats.h"
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+World::World() : renderDistance((RENDER_DISTANCE_BLOCKS+CHUNK_SIZE-1)/CHUNK_SIZE),
+    evictionRadius(renderDistance+(EVICTION_MARGIN_BLOCKS+CHUNK_SIZE-1)/CHUNK_SIZE),
+    chunks(2*evictionRadius+1) {
+    //先创建共享任务系统：它晚于 World 析构，World 析构时仍可等待自己提交的任务
+    getJobSystem();
+}
+
+World::~World(){ 
+    //已排队的任务仍会执行但立即返回（只释放 chunk 引用），等它们全部结束
+    shuttingDown=true;
+    while (outstandingJobs.load()>0) std::this_thread::yield();
+
+    //先丢弃队列中的引用，再删除 chunks
+    uploadQueue.clear();
+    cancelledChunks.clear();
+    generatedChunks.clear();
+    meshWaiting.clear();
+    scheduled.clear();
+    for(Chunk* c: chunks) 
+        delete c;
+    //任务已全部结束，不再有读者
+    for(auto &r : retiredChunks)
+        delete r.first;
+}
+
+void World::submitJob(std::function<void()> job) {
+    ++outstandingJobs;
+    getJobSystem().submit([this,job]() {
+        if(!shuttingDown) job();
+        --outstandingJobs;
+    });
+}
+
+//地形任务：只生成地形，完成后推入 generatedChunks；由 processGenerated 调用 awaitNeighbours 进入依赖等待，
+//updateMeshDependencies 在四个邻居地形就绪（或等待超时）后才提交网格构建
+void World::submitTerrainJob(Chunk* c) {
+    ++pendingTerrainJobs;
+    ScheduledTask task;
+    task.priority=chunkPriority(c->getChunkX(),c->getChunkZ());
+    task.terrain=true;
+    task.epoch=c->getJobEpoch();
+    task.req.chunk=ChunkHandle(c);//任务持有引用，完成前不会被驱逐
+    schedule(std::move(task));
+}
+
+//网格任务：仅 CPU 构建，结果推入上传队列
+void World::submitBuildJob(const BuildRequest &req) {
+    ++pendingBuildJobs;
+    ScheduledTask task;
+    task.priority=buildPriority(req.chunk.get(),req.urgent);
+    task.terrain=false;
+    task.epoch=req.chunk->getJobEpoch();
+    task.req=req;
+    schedule(std::move(task));
+}
+
+void World::schedule(ScheduledTask task) {
+    {
+        std::lock_guard<std::mutex> lk(scheduleMutex);
+        scheduled.push_back(std::move(task));
+        std::push_heap(scheduled.begin(),scheduled.end(),laterTask);
+    }
+    submitJob([this]() { runScheduledTask();});
+}
+
+void World::runScheduledTask() {
+    ScheduledTask task;
+    {
+        std::lock_guard<std::mutex> lk(scheduleMutex);
+        if(scheduled.empty()) return;
+        std::pop_heap(scheduled.begin(),scheduled.end(),laterTask);
+        task=std::move(scheduled.back());
+        scheduled.pop_back();
+    }
+    const BuildRequest &req=task.req;
+    if(req.chunk->isJobCancelled(task.epoch)) {
+        cancelTask(task,CANCEL_QUEUED);
+        return;
+    }
+    auto start=std::chrono::steady_clock::now();
+    auto elapsedUs=[&start]() { return (long long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()-start).count();};
+    if(task.terrain) {
+        req.chunk->setState(CHUNK_GENERATING);
+        if(!req.chunk->generateTerrain(task.epoch)) {
+            req.chunk->setState(CHUNK_QUEUED);
+            long long us=elapsedUs();
+            jobWorkUs+=us;
+            wastedWorkUs+=us;
+            cancelTask(task,CANCEL_TERRAIN);
+            return;
+        }
+        req.chunk->setState(CHUNK_GENERATED);
+        jobWorkUs+=elapsedUs();
+        //交给主线程做依赖检查（之后才取消的由检查负责延后）；先入列再减计数，待处理任务数不会短暂为 0
+        {
+            std::lock_guard<std::mutex> ul(uploadMutex);
+            generatedChunks.push_back(std::move(task.req.chunk));
+        }
+        --pendingTerrainJobs;
+        return;
+    }
+    req.chunk->setState(CHUNK_MESHING);
+    //每个工作线程复用一份快照，方块数组的容量在多次构建之间保留
+    thread_local MeshSnapshot snapshot;
+    snapshotForMeshing(req.chunk.get(),snapshot);
+    PendingUpload upload;
+    upload.data=Chunk::buildMeshCPU(snapshot);
+    long long us=elapsedUs();
+    jobWorkUs+=us;
+    if(req.chunk->isJobCancelled(task.epoch)) {
+        wastedWorkUs+=us;
+        cancelTask(task,CANCEL_AFTER_MESH);
+        return;
+    }
+    req.chunk->setState(CHUNK_MESH_READY);
+    upload.chunk=req.chunk;
+    upload.epoch=task.epoch;
+    upload.urgent=req.urgent;
+    pushUpload(std::move(upload));
+    --pendingBuildJobs;
+}
+
+void World::cancelTask(ScheduledTask &task,CancelStage stage) {
+    ++cancelledJobs[stage];
+    {
+        std::lock_guard<std::mutex> ul(uploadMutex);
+        cancelledChunks.push_back(std::move(task.req.chunk));
+    }
+    if(task.terrain) --pendingTerrainJobs;
+    else --pendingBuildJobs;
+}
+
+void World::processCancelled() {
+    std::vector<ChunkHandle> cancelled;
+    {
+        std::lock_guard<std::mutex> ul(uploadMutex);
+        if(cancelledChunks.empty()) return;
+        cancelled.swap(cancelledChunks);
+    }
+    for(ChunkHandle &h : cancelled) deferCancelled(h.get());
+}
+
+void World::deferCancelled(Chunk* c) {
+    //pendingBuild 保持为 true：延后期间不会被 render 补交重建，也不会重复提交
+    c->setJobDeferred(true);
+    //地形已生成的 chunk 退回构建前的状态，重新提交时做完整重建
+    if(c->hasTerrain()) c->setState(c->hasMesh() ? CHUNK_UPLOADED : CHUNK_GENERATED);
+}
+
+void World::pushUpload(PendingUpload &&upload) {
+    std::lock_guard<std::mutex> ul(uploadMutex);
+    upload.sequence=uploadSequence++;
+    uploadQueue.push_back(std::move(upload));
+}
+
+//相机移动超过半个 chunk 或转向超过约 11 度时，按新相机重新打分；顺带移除已取消的任务
+//（对应的执行令牌出堆时发现堆已空或取到别的任务，不受影响）
+void World::rescoreScheduled() {
+    glm::vec2 moved(viewPos.x-scoredPos.x,viewPos.z-scoredPos.z);
+    if(glm::length(moved)<CHUNK_SIZE*0.5f && glm::dot(viewFront,scoredFront)>=0.98f) return;
+    scoredPos=viewPos;
+    scoredFront=viewFront;
+    std::vector<ScheduledTask> dropped;
+    {
+        std::lock_guard<std::mutex> lk(scheduleMutex);
+        size_t kept=0;
+        for(auto &t : scheduled) {
+            if(t.req.chunk->isJobCancelled(t.epoch)) {
+                dropped.push_back(std::move(t));
+                continue;
+            }
+            t.priority=buildPriority(t.req.chunk.get(),t.req.urgent);
+            if(&scheduled[kept]!=&t) scheduled[kept]=std::move(t);
+            ++kept;
+        }
+        scheduled.erase(scheduled.begin()+kept,scheduled.end());
+        std::make_heap(scheduled.begin(),scheduled.end(),laterTask);
+    }
+    for(auto &t : dropped) cancelTask(t,CANCEL_QUEUED);
+}
+
+namespace {
+    constexpr float VIEW_COS=0.6f;//视锥半角约 53 度
+    constexpr float NEAR_CHUNKS=1.5f;//此距离内不看方向
+}
+
+float World::chunkPriority(int chunkX,int chunkZ) const {
+    float p=viewPriority(chunkX,chunkZ);
+    for(int side=0;side<4;++side)
+        p=std::min(p,viewPriority(chunkX+SIDE_DX[side],chunkZ+SIDE_DZ[side])+1.0f);
+    return p;
+}
+
+float World::buildPriority(const Chunk* c,bool urgent) const {
+    float p=chunkPriority(c->getChunkX(),c->getChunkZ());
+    return urgent ? p-EDIT_PRIORITY_BOOST : p;
+}
+
+float World::viewPriority(int chunkX,int chunkZ) const {
+    glm::vec2 to((chunkX+0.5f)*CHUNK_SIZE-viewPos.x,(chunkZ+0.5f)*CHUNK_SIZE-viewPos.z);
+    float dist=glm::length(to)/CHUNK_SIZE;
+    if(dist<NEAR_CHUNKS) return dist;
+    glm::vec2 front(viewFront.x,viewFront.z);
+    float frontLen=glm::length(front);
+    if(frontLen<1e-3f) return dist;//竖直朝向时只按距离
+    float cosAngle=glm::dot(to,front)/(dist*CHUNK_SIZE*frontLen);
+    if(cosAngle>=VIEW_COS) return dist;
+    return dist*(1.0f+2.0f*(VIEW_COS-cosAngle));
+}
+
+void World::updateGroundTimer(int playerChunkX,int playerChunkZ) {
+    int jump=std::max(std::abs(playerChunkX-lastPlayerChunkX),std::abs(playerChunkZ-lastPlayerChunkZ));
+    const char* reason=nullptr;
+    if(!viewInitialized) reason="spawn";
+    else if(jump>TELEPORT_CHUNKS) reason="teleport";
+    viewInitialized=true;
+    lastPlayerChunkX=playerChunkX;
+    lastPlayerChunkZ=playerChunkZ;
+    if(reason) {
+        groundTimer=GroundTimer();
+        groundTimer.active=true;
+        groundTimer.reason=reason;
+        groundTimer.start=std::chrono::steady_clock::now();
+    }
+    if(groundTimer.active) ++groundTimer.frames;
+}
+
+void World::checkGroundTimer() {
+    if(!groundTimer.active) return;
+    double ms=std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-groundTimer.start).count();
+    if(groundTimer.groundMs<0.0) {
+        Chunk* c=chunks.find(lastPlayerChunkX,lastPlayerChunkZ);
+        if(!c || !c->hasMesh()) return;
+        groundTimer.groundMs=ms;
+        groundTimer.groundFrames=groundTimer.frames;
+    }
+    for(int x=-NEAR_VIEW_RADIUS;x<=NEAR_VIEW_RADIUS;++x) {
+        for(int z=-NEAR_VIEW_RADIUS;z<=NEAR_VIEW_RADIUS;++z) {
+            if(x*x+z*z>NEAR_VIEW_RADIUS*NEAR_VIEW_RADIUS) continue;
+            int cx=lastPlayerChunkX+x,cz=lastPlayerChunkZ+z;
+            if(!isInViewCone(cx,cz)) continue;
+            Chunk* c=chunks.find(cx,cz);
+            if(!c || !c->hasMesh()) return;
+        }
+    }
+    groundTimer.active=false;
+    lastGroundMs=groundTimer.groundMs;
+    lastNearViewMs=ms;
+    std::cout<<"[Streaming] first visible ground after "<<groundTimer.reason<<": "<<groundTimer.groundMs<<" ms ("
+        <<groundTimer.groundFrames<<" frames), near view "<<ms<<" ms ("<<groundTimer.frames<<" frames)"<<std::endl;
+}
+
+bool World::isInViewCone(int chunkX,int chunkZ) const {
+    glm::vec2 to((chunkX+0.5f)*CHUNK_SIZE-viewPos.x,(chunkZ+0.5f)*CHUNK_SIZE-viewPos.z);
+    float dist=glm::length(to)/CHUNK_SIZE;
+    if(dist<NEAR_CHUNKS) return true;
+    glm::vec2 front(viewFront.x,viewFront.z);
+    float frontLen=glm::length(front);
+    if(frontLen<1e-3f) return true;
+    return glm::dot(to,front)/(dist*CHUNK_SIZE*frontLen)>=VIEW_COS;
+}
+
+Chunk* World::createChunk(int chunkX,int chunkZ) {
+    Chunk* c=chunkPool.acquire(chunkX,chunkZ);
+    //地形生成并上传完成前视为构建中：驱逐不会在工作线程仍使用它时把它归还对象池
+    c->setPendingBuild(true);
+    c->setState(CHUNK_QUEUED);
+    //网格只由主线程写入，工作线程经发布指针无锁读取，插入无需持锁
+    chunks.insert(c);
+    submitTerrainJob(c);
+    return c;
+}
+
+Chunk* World::getChunk(int chunkX,int chunkZ){ 
+    Chunk* existing=chunks.find(chunkX,chunkZ);
+    if(existing) return existing;
+    ++chunksCreatedOutsideStreamer;
+    return createChunk(chunkX,chunkZ);
+}
+
+Chunk* World::chunkAt(int chunkX,int chunkZ,UnloadedPolicy policy) {
+    if(policy==UNLOADED_CREATE) return getChunk(chunkX,chunkZ);
+    return chunks.find(chunkX,chunkZ);
+}
+
+BlockType World::getBlock(int x,int y,int z,UnloadedPolicy policy){ 
+    Chunk* c=chunkAt(ChunkLayout::chunkOfX(x),ChunkLayout::chunkOfZ(z),policy);
+    if(!c) return (policy==UNLOADED_AS_SOLID && y>=0 && y<getWorldHeight()) ? STONE : AIR;
+    return c->getBlock(ChunkLayout::localX(x),y,ChunkLayout::localZ(z));
+}
+
+bool World::tryGetBlock(int x,int y,int z,BlockType &out) const {
+    EpochManager::ReadGuard guard(directoryEpochs);
+    Chunk* c=findChunkConcurrent(ChunkLayout::chunkOfX(x),ChunkLayout::chunkOfZ(z));
+    if(!c) return false;
+    out=c->getBlock(ChunkLayout::localX(x),y,ChunkLayout::localZ(z));
+    return true;
+}
+
+void World::readBox(const glm::ivec3& min,const glm::ivec3& max,BlockBox& out,UnloadedPolicy policy) {
+    out.min=min;
+    out.max=max;
+    if(max.x<min.x || max.y<min.y || max.z<min.z) {
+        out.blocks.clear();
+        return;
+    }
+    const int sizeX=max.x-min.x+1;
+    const int sizeZ=max.z-min.z+1;
+    out.blocks.assign((size_t)sizeX*(max.y-min.y+1)*sizeZ,AIR);
+    //纵向裁剪到世界高度，范围外保持 AIR
+    const int y0=std::max(min.y,0);
+    const int y1=std::min(max.y,getWorldHeight()-1);
+    if(y0>y1) return;
+    for(int cx=ChunkLayout::chunkOfX(min.x);cx<=ChunkLayout::chunkOfX(max.x);++cx) {
+        for(int cz=ChunkLayout::chunkOfZ(min.z);cz<=ChunkLayout::chunkOfZ(max.z);++cz) {
+            Chunk* c=chunkAt(cx,cz,policy);
+            int x0=std::max(min.x,cx*CHUNK_SIZE),x1=std::min(max.x,cx*CHUNK_SIZE+CHUNK_SIZE-1);
+            int z0=std::max(min.z,cz*CHUNK_SIZE),z1=std::min(max.z,cz*CHUNK_SIZE+CHUNK_SIZE-1);
+            if(c) {
+                c->readRegion(ChunkLayout::localX(x0),ChunkLayout::localX(x1),y0,y1,ChunkLayout::localZ(z0),ChunkLayout::localZ(z1),
+                    &out.blocks[out.index(x0,y0,z0)],sizeX*sizeZ,sizeX);
+            } else if(policy==UNLOADED_AS_SOLID) {
+                for(int y=y0;y<=y1;++y)
+                    for(int z=z0;z<=z1;++z) {
+                        BlockType* row=&out.blocks[out.index(x0,y,z)];
+                        std::fill(row,row+(x1-x0+1),STONE);
+                    }
+            }
+        }
+    }
+}
+
+Chunk* World::chunkForColumn(int x,int z,int &localX,int &localZ,UnloadedPolicy policy) {
+    localX=ChunkLayout::localX(x);
+    localZ=ChunkLayout::localZ(z);
+    return chunkAt(ChunkLayout::chunkOfX(x),ChunkLayout::chunkOfZ(z),policy);
+}
+
+bool World::isColumnLoaded(int x,int z) const {
+    return chunks.contains(ChunkLayout::chunkOfX(x),ChunkLayout::chunkOfZ(z));
+}
+
+int World::getTopSolidY(int x,int z,UnloadedPolicy policy) {
+    int lx,lz;
+    Chunk* c=chunkForColumn(x,z,lx,lz,policy);
+    if(!c) return policy==UNLOADED_AS_SOLID ? getWorldHeight()-1 : -1;
+    return c->getTopSolidY(lx,lz);
+}
+
+ColumnMask World::getSolidColumn(int x,int z,int baseY,UnloadedPolicy policy) {
+    int lx,lz;
+    Chunk* c=chunkForColumn(x,z,lx,lz,policy);
+    if(!c) return policy==UNLOADED_AS_SOLID ? columnRangeMask(-baseY,getWorldHeight()-1-baseY) : 0;
+    return c->getSolidMask(lx,lz,baseY);
+}
+
+ColumnMask World::getFluidColumn(int x,int z,int baseY,UnloadedPolicy policy) {
+    int lx,lz;
+    Chunk* c=chunkForColumn(x,z,lx,lz,policy);
+    if(!c) return 0;
+    return c->getFluidMask(lx,lz,baseY);
+}
+
+bool World::isSolidAt(int x,int y,int z,UnloadedPolicy policy) {
+    if(y<0 || y>=getWorldHeight()) return false;
+    return getSolidColumn(x,z,y,policy)&1;
+}
+
+bool World::isFluidAt(int x,int y,int z,UnloadedPolicy policy) {
+    if(y<0 || y>=getWorldHeight()) return false;
+    return getFluidColumn(x,z,y,policy)&1;
+}
+
+//获取存在的 block，不创建缺失 chunk，未加载返回 AIR
+BlockType World::getBlockIfLoaded(int x,int y,int z) const {
+    BlockType type=AIR;
+    tryGetBlock(x,y,z,type);
+    return type;
+}
+
+bool World::hasChunkLoaded(int chunkX,int chunkZ) const {
+    EpochManager::ReadGuard guard(directoryEpochs);
+    return findChunkConcurrent(chunkX,chunkZ)!=nullptr;
+}
+
+//调用方需处于 directoryEpochs 读临界区，返回的 chunk 在退出临界区前不会被回收
+Chunk* World::findChunkConcurrent(int chunkX,int chunkZ) const {
+    return chunks.findConcurrent(chunkX,chunkZ);
+}
+
+//归还已没有读者能看到的退休 chunk
+void World::reclaimRetiredChunks() {
+    if(retiredChunks.empty()) return;
+    uint64_t safe=directoryEpochs.safeEpoch();
+    size_t kept=0;
+    for(auto &r : retiredChunks) {
+        if(r.second<safe) chunkPool.release(r.first);
+        else retiredChunks[kept++]=r;
+    }
+    retiredChunks.resize(kept);
+}
+
+bool World::setBlock(int x,int y,int z,BlockType type){ 
+    int chunkX=ChunkLayout::chunkOfX(x);
+    int chunkZ=ChunkLayout::chunkOfZ(z);
+    int localX=ChunkLayout::localX(x);
+    int localZ=ChunkLayout::localZ(z);
+    //不为编辑创建 chunk：未加载的 chunk 之后会按地形重新生成，写入也会丢失
+    Chunk* c=chunks.find(chunkX,chunkZ);
+    if(!c) return false;
+    c->setBlock(localX,y,localZ,type);
+
+    //网格不在这里重建：记下此 chunk，触及区块边界时连同共享面的邻居，由下一次 updateChunks 提交异步重建
+    //邻居在本 chunk 写入之后才标记：邻居的快照若已看到新的编辑版本，拷到的边界也一定包含这次写入
+    noteEdit(c,false);
+    if(localX==0) noteEdit(chunks.find(chunkX-1,chunkZ),true);
+    if(localX==CHUNK_SIZE-1) noteEdit(chunks.find(chunkX+1,chunkZ),true);
+    if(localZ==0) noteEdit(chunks.find(chunkX,chunkZ-1),true);
+    if(localZ==CHUNK_SIZE-1) noteEdit(chunks.find(chunkX,chunkZ+1),true);
+    return true;
+}
+
+
+
+void World::updateChunks(const Camera& camera,const glm::vec3& lightDir){ 
+    FrameSlice creation(maxNewChunksPerFrame);
+    updateChunks(camera,lightDir,creation);
+}
+
+void World::updateChunks(const Camera& camera,const glm::vec3& lightDir,FrameSlice &creation){ 
+    int playerChunkX=(int)floor(camera.position.x/CHUNK_SIZE);
+    int playerChunkZ=(int)floor(camera.position.z/CHUNK_SIZE);
+    viewPos=camera.position;
+    viewFront=camera.front;
+    ++frameIndex;
+    updateGroundTimer(playerChunkX,playerChunkZ);
+    reclaimRetiredChunks();
+    chunks.recenter(playerChunkX,playerChunkZ);
+
+    //在途任务的 chunk 离开视距（加滞后余量）时取消任务；被取消而延后的 chunk 回到视距内时重新提交
+    const int genRadius=generationRadius();
+    const int keepRadius=genRadius+CANCEL_MARGIN_CHUNKS;
+    for(Chunk* c : chunks) {
+        if(!c->isPendingBuild()) continue;
+        int dx=c->getChunkX()-playerChunkX,dz=c->getChunkZ()-playerChunkZ;
+        int d2=dx*dx+dz*dz;
+        if(!c->isJobDeferred()) {
+            if(d2>keepRadius*keepRadius) c->cancelJobs();
+            continue;
+        }
+        if(d2>genRadius*genRadius) continue;
+        c->setJobDeferred(false);
+        if(c->hasMesh()) {
+            c->setPendingBuild(false);
+            requestRebuild(c);
+        } else if(c->hasTerrain()) awaitNeighbours(c);
+        else submitTerrainJob(c);
+    }
+    updateMeshDependencies(playerChunkX,playerChunkZ);
+    rescoreScheduled();
+    flushEdits();
+
+    //收集缺失的 chunk，按优先级创建最靠前的若干个（限制每帧新建数量，其余下帧继续）
+    //只有主线程修改网格，这里的读取无需加锁
+    std::vector<std::pair<float,glm::ivec2>> missing;
+    for(int x=-genRadius;x<=genRadius;++x) {
+        for(int z=-genRadius;z<=genRadius;++z) {
+            if(x*x+z*z>genRadius*genRadius) continue;
+            int cx=playerChunkX+x,cz=playerChunkZ+z;
+            if(chunks.contains(cx,cz)) continue;
+            missing.push_back({chunkPriority(cx,cz),glm::ivec2(cx,cz)});
+        }
+    }
+    size_t createCount=std::min(missing.size(),(size_t)std::max(0,creation.getMaxUnits()));
+    std::partial_sort(missing.begin(),missing.begin()+createCount,missing.end(),
+        [](const auto &a,const auto &b){ return a.first<b.first;});
+    for(size_t i=0;i<createCount && creation.more();++i) {
+        createChunk(missing[i].second.x,missing[i].second.y);
+        creation.done();
+    }
+    
+    //为需要更新且未在队列中的 chunk 提交构建请求
+    std::vector<BuildRequest> toSubmit;
+
+    for(Chunk* c : chunks) {
+        if(c->needsMeshUpdate() && !c->isPendingBuild()) {
+            c->setPendingBuild(true);
+            int dx=c->getChunkX()-playerChunkX,dz=c->getChunkZ()-playerChunkZ;
+            if(dx*dx+dz*dz>keepRadius*keepRadius) {
+                c->setJobDeferred(true);//视距外被修改的 chunk 等回到视距内再重建
+                continue;
+            }
+            BuildRequest req;
+            req.chunk=ChunkHandle(c);
+            toSubmit.push_back(std::move(req));
+        }
+    }
+
+    for(auto &r : toSubmit) submitBuildJob(r);
+
+    //驱逐远处 chunk 释放 GPU 资源
+    std::vector<Chunk*> candidates;
+    for(Chunk* c : chunks) {
+        int dx=std::abs(c->getChunkX()-playerChunkX);
+        int dz=std::abs(c->getChunkZ()-playerChunkZ);
+        if(std::max(dx,dz)>evictionRadius) candidates.push_back(c);//超出驱逐半径
+    }
+
+    for(Chunk* chunkPtr : candidates) {
+        //在途任务（地形/构建/上传队列条目）各持有一个引用：计数为 0 说明没有工作线程会再访问它，
+        //且只有主线程会新建引用，检查之后不会有新任务引用它
+        if(chunkPtr->getRefCount()>0) continue;
+        chunkPtr->setState(CHUNK_EVICTING);
+        //从网格撤下后，正在构建邻居网格的工作线程可能仍持有它（跨 chunk 的水面查找）：
+        //先退休，等这些读者退出后再由 reclaimRetiredChunks 归还对象池（在主 GL 线程，池可能 delete chunk 及其 GL 资源）
+        chunks.erase(chunkPtr->getChunkX(),chunkPtr->getChunkZ());
+        retiredChunks.push_back({chunkPtr,directoryEpochs.retire()});
+    }
+    //等待中的 chunk 被驱逐时以 nullptr 回调
+    processChunkRequests();
+}
+
+//检查 chunk 是否在视锥内（背面检测+粗略边界检查）
+bool World::isChunkInFrustum(Chunk* chunk,const Camera& camera,const glm::mat4& viewProj) const {
+    int cx=chunk->getChunkX();
+    int cz=chunk->getChunkZ();
+    
+    //包围盒只覆盖有内容的区段，世界加高后空的高空区段不影响剔除
+    int bottomY,topY;
+    chunk->getContentRange(bottomY,topY);
+    float contentHeight=(float)(topY-bottomY);
+
+    //Chunk 中心点（世界坐标）
+    glm::vec3 chunkCenter(
+        cx*CHUNK_SIZE+CHUNK_SIZE*0.5f,
+        bottomY+contentHeight*0.5f,
+        cz*CHUNK_SIZE+CHUNK_SIZE*0.5f
+    );
+    
+    //1. 快速背面检测：检查 chunk 中心是否在相机前方
+    glm::vec3 toChunk=chunkCenter-camera.position;
+    float distanceToChunk=glm::length(toChunk);
+    
+    //如果距离太近（玩家可能在 chunk 内），总是渲染
+    if(distanceToChunk<CHUNK_SIZE*1.5f) {
+        return true;
+    }
+    
+    glm::vec3 dirToChunk=toChunk/distanceToChunk;
+    float dotProduct=glm::dot(dirToChunk,camera.front);
+    
+    //如果点积小于阈值，说明 chunk 在相机后方或侧面很远
+    if(dotProduct<-0.5f) {
+        return false;
+    }
+    
+    //2. 粗略视锥检查：检查包围球是否与视锥相交
+    float boundingRadius=glm::length(glm::vec3(CHUNK_SIZE,contentHeight,CHUNK_SIZE))*0.5f;
+    glm::vec4 clipPos=viewProj*glm::vec4(chunkCenter,1.0f);
+    if(clipPos.w>0.0f) {
+        glm::vec3 ndc=glm::vec3(clipPos)/clipPos.w;
+        float ndcRadius=boundingRadius/clipPos.w*2.0f;//简化
+        if(ndc.x+ndcRadius<-1.0f || ndc.x-ndcRadius>1.0f ||
+            ndc.y+ndcRadius<-1.0f || ndc.y-ndcRadius>1.0f ||
+            ndc.z+ndcRadius<0.0f || ndc.z-ndcRadius>1.0f) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+void World::render(Shader& shader,const Camera& camera,const glm::vec3& lightDir){ 
+    glm::vec3 viewDir=camera.front;//获取相机视线方向
+
+    //计算 view-projection 矩阵用于视锥剔除
+    int width=WINDOW_WIDTH,height=WINDOW_HEIGHT;
+    glm::mat4 view=camera.getViewMatrix();
+    glm::mat4 projection=glm::perspective(glm::radians(45.0f),(float)width/(float)height,0.1f,200.0f);
+    glm::mat4 viewProj=projection*view;
+    
+    //收集可见 chunk；需要重建却不在任何队列中的 chunk 交给工作线程，渲染时不在主线程构建网格，先画旧网格
+    std::vector<Chunk*> visibleChunks;
+    visibleChunks.reserve(chunks.size());
+    for(Chunk* c: chunks) {
+        if(!isChunkInFrustum(c,camera,viewProj)) continue;
+        if(c->needsMeshUpdate() && !c->isPendingBuild()) requestRebuild(c,true);
+        visibleChunks.push_back(c);
+    }
+
+    //chunk 网格是打包顶点，各 chunk 绘制前设置自己的原点；渲染结束后恢复，球体等仍用浮点顶点
+    shader.setInt("usePackedVertex",1);
+
+    //1) 不透明通道：渲染所有可见 chunk 的不透明几何，每个 chunk 只绘制可能朝向相机的面方向
+    opaqueQuadsDrawn=opaqueQuadsTotal=0;
+    for(Chunk* c : visibleChunks) {
+        opaqueQuadsDrawn+=c->renderOpaque(shader,&camera.position);
+        opaqueQuadsTotal+=c->opaqueQuadCount();
+    }
+
+    //2) 透明通道：收集所有透明面，全局排序后从远到近绘制
+    std::vector<std::tuple<float,int,int,Chunk*>> transFaces;
+    transFaces.reserve(1024);
+    for(Chunk* c : visibleChunks)
+        c->collectTransparentFaces(transFaces,&viewDir,&camera.position);
+
+    std::sort(transFaces.begin(),transFaces.end(),[](const auto &a,const auto &b){ return std::get<0>(a)>std::get<0>(b);});
+
+    //绘制排序后的透明面，开启混合并禁用深度写入
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+    shader.setFloat("specularStrength",0.0f);
+    for(auto &t : transFaces) {
+        int texIndex=std::get<1>(t);
+        int faceIdx=std::get<2>(t);
+        Chunk* chunkPtr=std::get<3>(t);
+        chunkPtr->drawTransparentFace(shader,texIndex,faceIdx);
+    }
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+    shader.setInt("usePackedVertex",0);
+}
+
+//从工作线程处理上传到 GPU 的网格（在主 GL 线程调用）
+//超出本帧配额时按当前优先级挑选，优先级相同（同一 chunk）按产生顺序
+void World::processUploads(int maxUploads) {
+    FrameSlice slice(maxUploads);
+    processUploads(slice);
+}
+
+namespace {
+    //上传的权重：顶点数据 KB（glBufferData 耗时大致与数据量成正比）
+    double uploadKB(const MeshData &data) {
+        size_t bytes=0;
+        for(const auto &v : data.verticesByType) bytes+=v.size()*sizeof(PackedVertex);
+        return bytes/1024.0;
+    }
+}
+
+//时间片不够时，按 sequence 排好的候选中没上传的放回队列，下帧重新按优先级挑选
+int World::processUploads(FrameSlice &slice) {
+    processCancelled();
+    processGenerated();
+    std::vector<PendingUpload> batch;
+    takeBestUploads(slice.getMaxUnits(),batch);
+    //同一 chunk 的结果优先级相同，按 sequence 保证新结果最后上传
+    std::sort(batch.begin(),batch.end(),[](const PendingUpload &a,const PendingUpload &b){ return a.sequence<b.sequence;});
+    size_t i=0;
+    for(;i<batch.size();++i) {
+        double kb=uploadKB(batch[i].data);
+        if(!slice.more(kb)) break;
+        uploadPending(batch[i]);
+        slice.done(kb);
+    }
+    if(i<batch.size()) {
+        std::lock_guard<std::mutex> lk(uploadMutex);
+        for(;i<batch.size();++i) uploadQueue.push_back(std::move(batch[i]));
+    }
+    checkGroundTimer();
+    processChunkRequests();
+    return slice.getUnits();
+}
+
+//取出优先级最高的至多 maxUploads 条上传
+void World::takeBestUploads(int maxUploads,std::vector<PendingUpload> &batch) {
+    std::lock_guard<std::mutex> lk(uploadMutex);
+    if(uploadQueue.empty() || maxUploads<=0) return;
+    if((int)uploadQueue.size()<=maxUploads) {
+        batch.swap(uploadQueue);
+        return;
+    }
+    std::vector<std::pair<float,uint64_t>> keys;
+    keys.reserve(uploadQueue.size());
+    for(auto &u : uploadQueue)
+        keys.push_back({buildPriority(u.chunk.get(),u.urgent),u.sequence});
+    std::nth_element(keys.begin(),keys.begin()+(maxUploads-1),keys.end());
+    const std::pair<float,uint64_t> cutoff=keys[maxUploads-1];
+    std::vector<PendingUpload> rest;
+    rest.reserve(uploadQueue.size()-maxUploads);
+    for(auto &u : uploadQueue) {
+        std::pair<float,uint64_t> key(buildPriority(u.chunk.get(),u.urgent),u.sequence);
+        if(key<=cutoff) batch.push_back(std::move(u));
+        else rest.push_back(std::move(u));
+    }
+    uploadQueue.swap(rest);
+}
+
+namespace {
+    bool reachedStage(const Chunk* c,ChunkState stage) {
+        if(stage<=CHUNK_GENERATED) return c->hasTerrain();
+        if(stage<=CHUNK_MESH_READY) return c->hasMesh() || c->getState()==CHUNK_MESH_READY;
+        return c->hasMesh();
+    }
+}
+
+void World::requestChunk(int chunkX,int chunkZ,ChunkState stage,ChunkCallback onReady) {
+    Chunk* c=chunks.find(chunkX,chunkZ);
+    if(!c) c=createChunk(chunkX,chunkZ);
+    else if(reachedStage(c,stage)) {
+        onReady(c);
+        return;
+    }
+    chunkRequests.push_back({chunkX,chunkZ,stage,std::move(onReady)});
+}
+
+//回调可能再发起请求，先把到达的请求全部取出再调用
+void World::processChunkRequests() {
+    if(chunkRequests.empty()) return;
+    std::vector<ChunkRequest> waiting;
+    waiting.swap(chunkRequests);
+    std::vector<std::pair<Chunk*,ChunkCallback>> ready;
+    for(auto &r : waiting) {
+        Chunk* c=chunks.find(r.chunkX,r.chunkZ);
+        if(c && !reachedStage(c,r.stage)) chunkRequests.push_back(std::move(r));
+        else ready.push_back({c,std::move(r.onReady)});
+    }
+    for(auto &r : ready) r.second(r.first);
+}
+
+void World::uploadPending(PendingUpload &upload) {
+    //条目持有引用，chunk 不会在排队期间被驱逐或复用，无需再按坐标查找
+    Chunk* c=upload.chunk.get();
+    if(c->isJobCancelled(upload.epoch)) {
+        ++cancelledJobs[CANCEL_UPLOAD];
+        deferCancelled(c);
+        return;
+    }
+    if(!c->hasMesh()) ++chunksMeshed;
+    ++meshBuilds;
+    //移动之前记下之后要用的元数据；顶点上传后随 upload 释放，chunk 只移入绘制所需的元数据
+    const uint32_t meshEditVersion=upload.data.editVersion;
+    const uint8_t missingSides=upload.data.missingSides;
+    c->uploadMeshFromData(std::move(upload.data));
+    c->setState(CHUNK_UPLOADED);
+    if(meshEditVersion!=c->getEditVersion()) {
+        //构建开始后又被编辑：先显示这一版，再按最新方块重建
+        ++staleEditMeshes;
+        requestRebuild(c,true);
+    } else if(c->hasUnseenEdit()) {
+        double ms=std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-c->getUnseenEditTime()).count();
+        ++editLatencySamples;
+        editLatencySumMs+=ms;
+        editLatencyMaxMs=std::max(editLatencyMaxMs,ms);
+        c->setUnseenEdit(false);
+    }
+    //邻居在快照之后才生成：生成事件发生时本 chunk 在途（重建请求被忽略），在这里补建
+    //与快照使用同样的可见性（溢出表中的 chunk 对快照不可见，按缺失处理），避免反复重建
+    for(int side=0;side<4;++side) {
+        if(!(missingSides&(1<<side))) continue;
+        Chunk* n=chunks.findConcurrent(c->getChunkX()+SIDE_DX[side],c->getChunkZ()+SIDE_DZ[side]);
+        if(!n || !n->hasTerrain()) continue;
+        if(requestRebuild(c)) ++borderRemeshes;
+        break;
+    }
+}
+
+bool World::requestRebuild(Chunk* c,bool urgent) {
+    if(c->isPendingBuild()) return false;//在途的构建上传时会再检查一次
+    c->setPendingBuild(true);
+    BuildRequest req;
+    req.chunk=ChunkHandle(c);
+    req.urgent=urgent;
+    submitBuildJob(req);
+    return true;
+}
+
+void World::noteEdit(Chunk* c,bool neighbour) {
+    if(!c) return;
+    if(neighbour) c->markEdited();
+    else if(!c->hasUnseenEdit()) c->setUnseenEdit(true,std::chrono::steady_clock::now());
+    //连续编辑大多落在同一 chunk，只和上一条比较，其余重复在 flushEdits 中去掉
+    if(editedChunks.empty() || editedChunks.back().get()!=c) editedChunks.push_back(ChunkHandle(c));
+}
+
+//提交上一帧以来被编辑的 chunk 的重建（主线程）
+void World::flushEdits() {
+    if(editedChunks.empty()) return;
+    std::sort(editedChunks.begin(),editedChunks.end(),[](const ChunkHandle &a,const ChunkHandle &b){ return a.get()<b.get();});
+    editedChunks.erase(std::unique(editedChunks.begin(),editedChunks.end(),
+        [](const ChunkHandle &a,const ChunkHandle &b){ return a.get()==b.get();}),editedChunks.end());
+    for(ChunkHandle &h : editedChunks) {
+        Chunk* c=h.get();
+        //地形未生成、等待邻居或被延后的 chunk，之后的首次构建自然会读到最新方块
+        if(!c->hasTerrain() || c->isJobDeferred()) continue;
+        if(requestRebuild(c,true)) ++editRemeshes;
+        else promoteBuild(c);
+    }
+    editedChunks.clear();
+}
+
+void World::promoteBuild(Chunk* c) {
+    std::lock_guard<std::mutex> lk(scheduleMutex);
+    for(auto &t : scheduled) {
+        if(t.terrain || t.req.chunk.get()!=c || t.req.urgent) continue;
+        t.req.urgent=true;
+        t.priority=buildPriority(c,true);
+        std::make_heap(scheduled.begin(),scheduled.end(),laterTask);
+        return;
+    }
+}
+
+//地形生成完成：本 chunk 进入依赖等待；已有网格且缺这一侧的邻居立即重建边界
+void World::processGenerated() {
+    std::vector<ChunkHandle> generated;
+    {
+        std::lock_guard<std::mutex> ul(uploadMutex);
+        if(generatedChunks.empty()) return;
+        generated.swap(generatedChunks);
+    }
+    for(ChunkHandle &h : generated) {
+        Chunk* c=h.get();
+        awaitNeighbours(c);
+        for(int side=0;side<4;++side) {
+            Chunk* n=chunks.findConcurrent(c->getChunkX()+SIDE_DX[side],c->getChunkZ()+SIDE_DZ[side]);
+            if(!n || !n->hasMesh() || !(n->getMeshMissingSides()&(1<<(side^1)))) continue;
+            if(requestRebuild(n)) ++borderRemeshes;
+        }
+    }
+    //立即检查，不必等下一次 updateChunks
+    updateMeshDependencies(lastPlayerChunkX,lastPlayerChunkZ);
+}
+
+//pendingBuild 保持为 true：等待期间不会被 render 补交重建
+void World::awaitNeighbours(Chunk* c) {
+    MeshWait w;
+    w.chunk=ChunkHandle(c);
+    w.sinceFrame=frameIndex;
+    meshWaiting.push_back(std::move(w));
+}
+
+void World::updateMeshDependencies(int playerChunkX,int playerChunkZ) {
+    const int genRadius=generationRadius();
+    const int keepRadius=genRadius+CANCEL_MARGIN_CHUNKS;
+    size_t kept=0;
+    meshWaitingInView=0;
+    for(size_t i=0;i<meshWaiting.size();++i) {
+        Chunk* c=meshWaiting[i].chunk.get();
+        int dx=c->getChunkX()-playerChunkX,dz=c->getChunkZ()-playerChunkZ;
+        int d2=dx*dx+dz*dz;
+        if(d2>keepRadius*keepRadius) {
+            c->setJobDeferred(true);//已离开生成半径，回来后再等待
+            continue;
+        }
+        bool ready=false;
+        if(d2>renderDistance*renderDistance) {
+            meshWaiting[i].sinceFrame=frameIndex;//视距外的一圈只生成地形
+        } else {
+            //与快照相同的可见性：溢出表中的 chunk 对快照不可见
+            int waitingFor=0;
+            for(int side=0;side<4;++side) {
+                int nx=c->getChunkX()+SIDE_DX[side],nz=c->getChunkZ()+SIDE_DZ[side];
+                Chunk* n=chunks.findConcurrent(nx,nz);
+                if(n) {
+                    if(!n->hasTerrain() && !n->isJobDeferred()) ++waitingFor;
+                } else {
+                    int ndx=nx-playerChunkX,ndz=nz-playerChunkZ;
+                    if(ndx*ndx+ndz*ndz<=genRadius*genRadius) ++waitingFor;//生成半径内，稍后会创建
+                }
+            }
+            ready=waitingFor==0;
+            if(!ready && frameIndex-meshWaiting[i].sinceFrame>=(uint64_t)MAX_NEIGHBOUR_WAIT_FRAMES) {
+                ++forcedMeshes;
+                ready=true;
+            }
+        }
+        if(ready) {
+            c->setPendingBuild(false);
+            requestRebuild(c);
+            continue;
+        }
+        if(d2<=renderDistance*renderDistance) ++meshWaitingInView;
+        if(kept!=i) meshWaiting[kept]=std::move(meshWaiting[i]);
+        ++kept;
+    }
+    meshWaiting.erase(meshWaiting.begin()+kept,meshWaiting.end());
+}
+
+//拷贝 chunk 及四周已生成邻居的一格边界（任意线程；邻居经无锁目录查找，各自只加锁一次）
+void World::snapshotForMeshing(const Chunk* c,MeshSnapshot &out) const {
+    c->copyForMeshing(out);
+    EpochManager::ReadGuard guard(directoryEpochs);
+    for(int side=0;side<4;++side) {
+        Chunk* n=findChunkConcurrent(out.chunkX+SIDE_DX[side],out.chunkZ+SIDE_DZ[side]);
+        if(n && n->hasTerrain()) n->copyBorderTo(out,side);
+    }
+}
+
+//检查后台 worker 是否有待处理任务（任务计数在结果推入上传队列后才减少）
+bool World::hasPendingWork() const {
+    return getPendingTasksCount()>0;
+}
+int World::getPendingTasksCount() const {
+    std::lock_guard<std::mutex> ul(const_cast<std::mutex&>(uploadMutex));
+    return pendingTerrainJobs.load()+pendingBuildJobs.load()+static_cast<int>(uploadQueue.size()+cancelledChunks.size()+generatedChunks.size()+meshWaitingInView);
+}
+//检查初始地形生成及上传是否完成
+bool World::isInitialGenerationComplete() {
+    return !hasPendingWork();
+}
+//水模拟：在相机附近运行有限的水流更新（主循环约每秒调用一次）
+void World::simulateWater(const Camera& camera) {
+    int cx=(int)floor(camera.position.x);
+    int cy=(int)floor(camera.position.y);
+    int cz=(int)floor(camera.position.z);
+    int minX=cx-2*(int)REACH_DISTANCE;
+    int maxX=cx+2*(int)REACH_DISTANCE;
+    int minY=cy-2*(int)REACH_DISTANCE;
+    int maxY=cy+2*(int)REACH_DISTANCE;
+    int minZ=cz-2*(int)REACH_DISTANCE;
+    int maxZ=cz+2*(int)REACH_DISTANCE;
+
+    //区域内每列的流体掩码只读一次（第 i 位对应 maskBase+i 层）。处理第 y 层只会改动第 y 与 y-1 层，
+    //因此每一层在轮到它处理时的水分布与开始时的掩码一致
+    const int maskBase=minY-1;
+    const int spanX=maxX-minX+1;
+    const int spanZ=maxZ-minZ+1;
+    std::vector<ColumnMask> fluidCols(spanX*spanZ);
+    ColumnMask anyFluid=0;
+    for(int x=minX;x<=maxX;++x) {
+        for(int z=minZ;z<=maxZ;++z) {
+            ColumnMask m=getFluidColumn(x,z,maskBase,UNLOADED_AS_AIR);
+            fluidCols[(x-minX)*spanZ+(z-minZ)]=m;
+            anyFluid |= m;
+        }
+    }
+
+    int processMinY=minY;
+    if(minY>=0 && ((anyFluid>>(minY-maskBase))&1)) processMinY=minY-1;
+    if(processMinY<0) processMinY=0;
+
+    int processMaxY=maxY;
+    if((anyFluid>>(maxY-maskBase))&1) processMaxY=maxY+1;
+
+    //没有水的层无需扫描：只处理区域内最低到最高含水层
+    ColumnMask layers=anyFluid&columnRangeMask(processMinY-maskBase,processMaxY-maskBase);
+    if(layers==0) return;
+    int lowestWater=0;
+    while (((layers>>lowestWater)&1)==0) ++lowestWater;
+    processMinY=maskBase+lowestWater;
+    processMaxY=maskBase+highestSetBit(layers);
+
+    //同一列及其邻居大多落在同一 chunk，用游标避免逐方块查找
+    //未加载区域视为实心：水不会流向未加载的 chunk，也就不会为写入而创建 chunk
+    BlockCursor cursor(*this,UNLOADED_AS_SOLID);
+    for(int y=processMinY;y<=processMaxY;++y) {
+        struct Change { int x,y,z;BlockType t;};
+        std::vector<Change> pendingThisLayer;
+        if(((anyFluid>>(y-maskBase))&1)==0) continue;
+        for(int x=minX;x<=maxX;++x) {
+            for(int z=minZ;z<=maxZ;++z) {
+                if(((fluidCols[(x-minX)*spanZ+(z-minZ)]>>(y-maskBase))&1)==0) continue;
+                if(y-1>=0 && cursor.get(x,y-1,z)==AIR) {
+                    setBlock(x,y-1,z,WATER);
+                    pendingThisLayer.push_back({x,y,z,AIR});
+                    continue;
+                }
+                const int dx[4]={1,-1,0,0};
+                const int dz[4]={0,0,1,-1};
+                for(int i=0;i<4;++i) {
+                    int nx=x+dx[i];
+                    int nz=z+dz[i];
+                    char wn=0;
+                    if(cursor.get(nx-1,y,nz)==WATER)wn++;
+                    if(cursor.get(nx+1,y,nz)==WATER)wn++;
+                    if(cursor.get(nx,y,nz-1)==WATER)wn++;
+                    if(cursor.get(nx,y,nz+1)==WATER)wn++;
+                    if(wn<4 && cursor.get(x,y-1,z)==WATER) continue;
+                    if(nx<minX || nx>maxX || nz<minZ || nz>maxZ) continue;
+                    if(cursor.get(nx,y,nz)!=AIR) continue;
+                    BlockType belowTarget=(y-1>=0) ? cursor.get(nx,y-1,nz) : WATER;
+                    if(belowTarget!=AIR) {
+                        pendingThisLayer.push_back({nx,y,nz,WATER});
+                    } else {
+                        if(y-1>=0 && cursor.get(nx,y-1,nz)==AIR) {
+                            setBlock(nx,y-1,nz,WATER);
+                        }
+                    }
+                }
+            }
+        }
+        for(const auto &c : pendingThisLayer) setBlock(c.x,c.y,c.z,c.t);
+    }
+}
+
+//内存报告：统计常驻 chunk 的方块存储，并与旧格式（int 枚举三维数组）和每方块一字节基线对比
+void World::printMemoryReport() const {
+    size_t chunkCount=chunks.size();
+    size_t packedBytes=0;
+    size_t columnBytes=0;
+    size_t bitsHistogram[9]={ 0 };
+    for(Chunk* c : chunks) {
+        packedBytes += c->blockMemoryBytes();
+        columnBytes += c->columnMemoryBytes();
+        for(int s=0;s<getWorldSections();++s) bitsHistogram[c->sectionBitsPerEntry(s)]++;
+    }
+    const size_t voxelsPerChunk=(size_t)CHUNK_SIZE*getWorldHeight()*CHUNK_SIZE;
+    size_t legacyBytes=chunkCount*voxelsPerChunk*sizeof(int);
+    size_t byteBaseline=chunkCount*voxelsPerChunk;
+    double ratio=packedBytes>0 ? (double)legacyBytes/(double)packedBytes : 0.0;
+    std::cout<<"[Memory] chunks="<<chunkCount<<" ("<<CHUNK_SIZE<<"x"<<getWorldHeight()<<"x"<<CHUNK_SIZE<<")"
+        <<" blocks="<<packedBytes/1024<<"KB"
+        <<" (byte baseline "<<byteBaseline/1024<<"KB, legacy int "<<legacyBytes/1024<<"KB, "
+        <<ratio<<"x smaller)"<<std::endl;
+    std::cout<<"[Memory] sections by bits/entry: 0:"<<bitsHistogram[0]<<" 1:"<<bitsHistogram[1]
+        <<" 2:"<<bitsHistogram[2]<<" 4:"<<bitsHistogram[4]<<" 8:"<<bitsHistogram[8]<<std::endl;
+    std::cout<<"[Memory] column masks+heightmap="<<columnBytes/1024<<"KB"<<std::endl;
+    //网格顶点上传后不在 CPU 保留：对比保留顶点副本时的常驻量（顶点字节+同样的元数据）
+    size_t meshResident=0,meshVertices=0;
+    for(Chunk* c : chunks) {
+        meshResident+=c->meshResidentBytes();
+        meshVertices+=c->meshVertexBytes();
+    }
+    std::cout<<"[Memory] resident CPU mesh data="<<meshResident/1024<<"KB (with vertex copies "<<(meshResident+meshVertices)/1024
+        <<"KB), uploaded vertices="<<meshVertices/1024<<"KB"<<std::endl;
+    std::cout<<"[Streaming] chunks created outside updateChunks="<<chunksCreatedOutsideStreamer<<std::endl;
+    size_t stateCount[CHUNK_STATE_COUNT]={ 0 };
+    for(Chunk* c : chunks) stateCount[c->getState()]++;
+    std::cout<<"[Streaming] states: queued="<<stateCount[CHUNK_QUEUED]<<" generating="<<stateCount[CHUNK_GENERATING]
+        <<" generated="<<stateCount[CHUNK_GENERATED]<<" meshing="<<stateCount[CHUNK_MESHING]
+        <<" meshReady="<<stateCount[CHUNK_MESH_READY]<<" uploaded="<<stateCount[CHUNK_UPLOADED]
+        <<" retired="<<retiredChunks.size()<<std::endl;
+    std::cout<<"[Streaming] meshing: chunks="<<chunksMeshed<<" builds="<<meshBuilds<<" ("
+        <<(chunksMeshed>0 ? (double)meshBuilds/chunksMeshed : 0.0)<<" per chunk) borderRemeshes="<<borderRemeshes
+        <<" forcedBeforeNeighbours="<<forcedMeshes<<" waiting="<<meshWaitingInView<<"/"<<meshWaiting.size()<<std::endl;
+    long long workUs=jobWorkUs.load(),wastedUs=wastedWorkUs.load();
+    std::cout<<"[Streaming] cancelled jobs: queued="<<cancelledJobs[CANCEL_QUEUED]<<" midTerrain="<<cancelledJobs[CANCEL_TERRAIN]
+        <<" afterMesh="<<cancelledJobs[CANCEL_AFTER_MESH]
+        <<" beforeUpload="<<cancelledJobs[CANCEL_UPLOAD]<<", wasted worker time "<<wastedUs/1000<<"/"<<workUs/1000<<" ms ("
+        <<(workUs>0 ? 100.0*wastedUs/workUs : 0.0)<<"%)"<<std::endl;
+    std::cout<<"[Streaming] edits: remeshes="<<editRemeshes<<" staleRebuilds="<<staleEditMeshes<<" edit-to-upload avg "
+        <<(editLatencySamples>0 ? editLatencySumMs/editLatencySamples : 0.0)<<" ms max "<<editLatencyMaxMs<<" ms ("<<editLatencySamples<<" samples)"<<std::endl;
+    std::cout<<"[Render] last frame opaque quads: submitted "<<opaqueQuadsDrawn<<"/"<<opaqueQuadsTotal<<" ("
+        <<(opaqueQuadsTotal>0 ? 100.0*opaqueQuadsDrawn/opaqueQuadsTotal : 0.0)<<"%) after face-direction culling"<<std::endl;
+    if(lastNearViewMs>=0.0)
+        std::cout<<"[Streaming] last spawn/teleport: first visible ground "<<lastGroundMs<<" ms, near view "<<lastNearViewMs<<" ms"<<std::endl;
+    chunkPool.printStats();
+}
+
+//查找基准：对当前常驻 chunk 的坐标（命中）与其平移后的坐标（大多未命中）交替查找
+void World::benchmarkChunkLookup() const {
+    if(chunks.empty()) {
+        std::cout<<"[ChunkLookup] no chunks loaded"<<std::endl;
+        return;
+    }
+    std::map<std::pair<int,int>,Chunk*> reference;
+    std::vector<std::pair<int,int>> keys;
+    for(Chunk* c : chunks) {
+        reference[{c->getChunkX(),c->getChunkZ()}]=c;
+        keys.push_back({c->getChunkX(),c->getChunkZ()});
+        keys.push_back({c->getChunkX()+3*evictionRadius,c->getChunkZ()});
+    }
+    const int rounds=std::max(1,2000000/(int)keys.size());
+    size_t sink=0;
+
+    auto t0=std::chrono::high_resolution_clock::now();
+    for(int r=0;r<rounds;++r)
+        for(auto &k : keys) {
+            auto it=reference.find(k);
+            if(it!=reference.end()) sink+=(size_t)it->second;
+        }
+    auto t1=std::chrono::high_resolution_clock::now();
+    for(int r=0;r<rounds;++r)
+        for(auto &k : keys) sink+=(size_t)chunks.find(k.first,k.second);
+    auto t2=std::chrono::high_resolution_clock::now();
+
+    double lookups=(double)rounds*keys.size();
+    double mapNs=std::chrono::duration<double,std::nano>(t1-t0).count()/lookups;
+    double gridNs=std::chrono::duration<double,std::nano>(t2-t1).count()/lookups;
+    std::cout<<"[ChunkLookup] chunks="<<chunks.size()<<" grid="<<chunks.width()<<"x"<<chunks.width()
+        <<" overflow="<<chunks.overflowCount()<<" std::map="<<mapNs<<"ns grid="<<gridNs<<"ns ("
+        <<(gridNs>0.0 ? mapNs/gridNs : 0.0)<<"x) checksum="<<(sink&0xFF)<<std::endl;
+}
+
+//网格争用基准：挑出含水列最多的常驻 chunk（边界水面需要跨 chunk 查找），在所有核心上反复快照并构建它们的网格
+//两轮都模拟旧的调度锁：线程取下一个任务、主线程扫描全部 chunk（updateChunks）都持同一把锁；
+//持锁一轮的目录查找也持这把锁（旧实现查找时持调度用的 buildMutex），无锁一轮按工作线程的真实路径查找
+//基准只用自己的锁与线程，不改变游戏中工作线程的查找路径；开始前先等共享任务系统空闲，避免真实任务混入计时
+void World::benchmarkMeshContention() {
+    std::vector<std::pair<int,Chunk*>> ranked;
+    for(Chunk* c : chunks) {
+        ChunkState st=c->getState();
+        if(st==CHUNK_QUEUED || st==CHUNK_GENERATING || st==CHUNK_EVICTING) continue;
+        int waterColumns=0;
+        for(int x=0;x<CHUNK_SIZE;++x)
+            for(int z=0;z<CHUNK_SIZE;++z)
+                for(int baseY=0;baseY<getWorldHeight();baseY+=64)
+                    if(c->getFluidMask(x,z,baseY)) {
+                        ++waterColumns;
+                        break;
+                    }
+        if(waterColumns>0) ranked.push_back({waterColumns,c});
+    }
+    if(ranked.empty()) {
+        std::cout<<"[MeshContention] no generated chunks with water loaded"<<std::endl;
+        return;
+    }
+    std::sort(ranked.begin(),ranked.end(),[](const std::pair<int,Chunk*>& a,const std::pair<int,Chunk*>& b) { return a.first>b.first;});
+    if(ranked.size()>64) ranked.resize(64);
+    //基准期间持有引用，chunk 不会被驱逐；快照只读 chunk，可与工作线程并发
+    std::vector<ChunkHandle> lake;
+    for(auto &r : ranked) lake.push_back(ChunkHandle(r.second));
+
+    getJobSystem().waitIdle();
+
+    const unsigned threadCount=std::max(1u,std::thread::hardware_concurrency());
+    const int rounds=4;
+    std::mutex scheduleLock;//模拟旧的 buildMutex
+    size_t mainScans=0,dirtySeen=0;
+    //与 snapshotForMeshing 相同，只是持锁一轮的邻居查找在 scheduleLock 内
+    auto snapshot=[&](const Chunk* c,MeshSnapshot &out,bool locked) {
+        c->copyForMeshing(out);
+        EpochManager::ReadGuard guard(directoryEpochs);
+        for(int side=0;side<4;++side) {
+            Chunk* n;
+            if(locked) {
+                std::lock_guard<std::mutex> lk(scheduleLock);
+                n=findChunkConcurrent(out.chunkX+SIDE_DX[side],out.chunkZ+SIDE_DZ[side]);
+            } else n=findChunkConcurrent(out.chunkX+SIDE_DX[side],out.chunkZ+SIDE_DZ[side]);
+            if(n && n->hasTerrain()) n->copyBorderTo(out,side);
+        }
+    };
+    auto run=[&](bool locked) {
+        size_t next=0;
+        const size_t total=lake.size()*rounds;
+        std::atomic<unsigned> running{threadCount};
+        std::vector<std::thread> threads;
+        auto t0=std::chrono::high_resolution_clock::now();
+        for(unsigned i=0;i<threadCount;++i)
+            threads.emplace_back([&]() {
+                MeshSnapshot s;
+                for(;;) {
+                    size_t job;
+                    {
+                        std::lock_guard<std::mutex> lk(scheduleLock);
+                        job=next++;
+                    }
+                    if(job>=total) break;
+                    snapshot(lake[job%lake.size()].get(),s,locked);
+                    Chunk::buildMeshCPU(s);
+                }
+                --running;
+            });
+        //主线程：每毫秒持锁扫描一遍全部 chunk（比每帧一次更密，放大与工作线程的争用）
+        while(running.load()>0) {
+            {
+                std::lock_guard<std::mutex> lk(scheduleLock);
+                for(Chunk* c : chunks)
+                    if(c->needsMeshUpdate() && !c->isPendingBuild()) ++dirtySeen;
+                ++mainScans;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        for(auto &t : threads) t.join();
+        auto t1=std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double,std::milli>(t1-t0).count();
+    };
+    run(false);//预热
+    double lockedMs=run(true);
+    double lockFreeMs=run(false);
+    std::cout<<"[MeshContention] chunks="<<lake.size()<<" waterColumns(top)="<<ranked.front().first
+        <<" threads="<<threadCount<<" meshes="<<lake.size()*rounds
+        <<" locked="<<lockedMs<<"ms lockFree="<<lockFreeMs<<"ms ("
+        <<(lockFreeMs>0.0 ? lockedMs/lockFreeMs : 0.0)<<"x), main-thread scans="<<mainScans<<" (dirty "<<dirtySeen<<")"<<std::endl;
+}
+
+namespace {
+    bool sameMesh(const MeshData &a,const MeshData &b) {
+        for(int i=0;i<NUM_BLOCK_TEXTURES;++i)
+            if(a.verticesByType[i]!=b.verticesByType[i]) return false;
+        return true;
+    }
+
+    //改动快照方块后按本 chunk 的格子重新计算区段标志与 meshTop（与 copyForMeshing 的含义一致）
+    void refreshSnapshotFlags(MeshSnapshot &s) {
+        const PaddedBlocks &b=s.blocks;
+        int top=0;
+        for(int sec=b.getBaseY()/SECTION_SIZE;sec<b.getTopY()/SECTION_SIZE;++sec) {
+            SectionFlags &f=s.sectionFlags[sec];
+            const BlockType first=b.at(0,sec*SECTION_SIZE,0);
+            f.uniform=true;
+            f.empty=true;
+            for(int y=sec*SECTION_SIZE;y<(sec+1)*SECTION_SIZE;++y)
+                for(int z=0;z<CHUNK_SIZE;++z)
+                    for(int x=0;x<CHUNK_SIZE;++x) {
+                        BlockType t=b.at(x,y,z);
+                        if(t!=first) f.uniform=false;
+                        if(t==AIR) continue;
+                        f.empty=false;
+                        top=std::max(top,y+1);
+                    }
+            f.type=f.uniform ? first : AIR;
+        }
+        s.meshTop=top;
+    }
+}
+
+//网格构建基准与等价性检查：对常驻 chunk 的快照分别运行逐方块与位掩码两种构建，逐字节比较输出并对比单线程耗时；
+//再把快照随机改动（含邻居边界，混入树叶、水、云）后比较一次，覆盖地形中少见的相邻组合
+void World::benchmarkMesher() {
+    std::vector<MeshSnapshot> snapshots;
+    for(Chunk* c : chunks) {
+        if(!c->hasTerrain() || c->getState()==CHUNK_EVICTING) continue;
+        snapshots.emplace_back();
+        snapshotForMeshing(c,snapshots.back());
+        if(snapshots.size()>=128) break;
+    }
+    if(snapshots.empty()) {
+        std::cout<<"[Mesher] no generated chunks loaded"<<std::endl;
+        return;
+    }
+
+    size_t mismatches=0,randomMismatches=0,randomTested=0;
+    for(const MeshSnapshot &s : snapshots)
+        if(!sameMesh(Chunk::buildMeshCPUScalar(s),Chunk::buildMeshCPU(s))) ++mismatches;
+    std::mt19937 rng(12345);
+    static const BlockType palette[]={ AIR,AIR,AIR,STONE,DIRT,GRASS,SAND,LEAVES,WATER,WATER,CLOUD };
+    const int paletteSize=(int)(sizeof(palette)/sizeof(palette[0]));
+    for(const MeshSnapshot &s : snapshots) {
+        const int baseY=s.blocks.getBaseY(),topY=s.blocks.getTopY();
+        if(topY<=baseY) continue;
+        MeshSnapshot m=s;
+        const int span=CHUNK_SIZE+2;
+        const int edits=(topY-baseY)*span*span/20;
+        for(int i=0;i<edits;++i) {
+            int x=(int)(rng()%span)-1,z=(int)(rng()%span)-1,y=baseY+(int)(rng()%(topY-baseY));
+            m.blocks.at(x,y,z)=palette[rng()%paletteSize];
+        }
+        refreshSnapshotFlags(m);
+        ++randomTested;
+        if(!sameMesh(Chunk::buildMeshCPUScalar(m),Chunk::buildMeshCPU(m))) ++randomMismatches;
+    }
+
+    const int rounds=8;
+    size_t vertexCount=0;
+    auto time=[&](MeshData (*build)(const MeshSnapshot&)) {
+        auto t0=std::chrono::high_resolution_clock::now();
+        vertexCount=0;
+        for(int r=0;r<rounds;++r)
+            for(const MeshSnapshot &s : snapshots) {
+                MeshData d=build(s);
+                for(const auto &v : d.verticesByType) vertexCount+=v.size();
+            }
+        auto t1=std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double,std::milli>(t1-t0).count()/(rounds*snapshots.size());
+    };
+    auto binary=[](const MeshSnapshot &s) { return Chunk::buildMeshCPU(s);};
+    double scalarMs=time(&Chunk::buildMeshCPUScalar);
+    double binaryMs=time(binary);
+    std::cout<<"[Mesher] chunks="<<snapshots.size()<<" scalar="<<scalarMs<<"ms/chunk bitmask="<<binaryMs<<"ms/chunk ("
+        <<(binaryMs>0.0 ? scalarMs/binaryMs : 0.0)<<"x), vertices/chunk="<<vertexCount/(rounds*snapshots.size())
+        <<" ("<<vertexCount*sizeof(PackedVertex)/1024.0/(rounds*snapshots.size())<<" KB)"<<std::endl;
+    std::cout<<"[Mesher] identical output: "<<snapshots.size()-mismatches<<"/"<<snapshots.size()<<" chunks, "
+        <<randomTested-randomMismatches<<"/"<<randomTested<<" randomized snapshots"<<std::endl;
+}
+
+//网格分配基准：按工作线程的路径（复用的快照 -> 构建 -> 移交）对常驻 chunk 轮流构建 1000 次网格，
+//分阶段统计堆分配次数与字节数。移交阶段把结果移入上传条目再移给接收方（对应上传前的排队，不含 GL 上传）
+void World::benchmarkMeshAllocations() {
+    if(!ALLOC_STATS_ENABLED) {
+        std::cout<<"[MeshAlloc] allocation counting is not compiled in (build with /p:YcAllocStats=true to define YC_ALLOC_STATS)"<<std::endl;
+        return;
+    }
+    std::vector<Chunk*> sources;
+    for(Chunk* c : chunks) {
+        if(!c->hasTerrain() || c->getState()==CHUNK_EVICTING) continue;
+        sources.push_back(c);
+        if(sources.size()>=128) break;
+    }
+    if(sources.empty()) {
+        std::cout<<"[MeshAlloc] no generated chunks loaded"<<std::endl;
+        return;
+    }
+    //计数是进程级的：先等共享任务系统空闲，避免工作线程上的地形/网格/纹理任务计入各阶段
+    getJobSystem().waitIdle();
+    const int builds=1000;
+    MeshSnapshot snapshot;
+    std::vector<MeshData> owners(sources.size());
+    //先把每个 chunk 构建一遍，让快照与线程局部缓冲达到稳定容量（与长时间运行的工作线程相同）
+    for(size_t i=0;i<sources.size();++i) {
+        snapshotForMeshing(sources[i],snapshot);
+        owners[i]=Chunk::buildMeshCPU(snapshot);
+    }
+    enum { SNAPSHOT,BUILD,HANDOFF,STAGES };
+    static const char* names[STAGES]={ "snapshot","build","hand-off" };
+    size_t count[STAGES]={},bytes[STAGES]={};
+    size_t vertexBytes=0;
+    auto t0=std::chrono::high_resolution_clock::now();
+    for(int i=0;i<builds;++i) {
+        const size_t k=i%sources.size();
+        AllocCounts a0=getAllocCounts();
+        snapshotForMeshing(sources[k],snapshot);
+        AllocCounts a1=getAllocCounts();
+        PendingUpload upload;
+        upload.data=Chunk::buildMeshCPU(snapshot);
+        AllocCounts a2=getAllocCounts();
+        for(const auto &v : upload.data.verticesByType) vertexBytes+=v.size()*sizeof(PackedVertex);
+        std::vector<PendingUpload> queue;
+        queue.reserve(1);
+        AllocCounts a3=getAllocCounts();
+        queue.push_back(std::move(upload));
+        owners[k]=std::move(queue.back().data);
+        AllocCounts a4=getAllocCounts();
+        count[SNAPSHOT]+=a1.count-a0.count;bytes[SNAPSHOT]+=a1.bytes-a0.bytes;
+        count[BUILD]+=a2.count-a1.count;bytes[BUILD]+=a2.bytes-a1.bytes;
+        count[HANDOFF]+=a4.count-a3.count;bytes[HANDOFF]+=a4.bytes-a3.bytes;
+    }
+    auto t1=std::chrono::high_resolution_clock::now();
+    size_t totalCount=0,totalBytes=0;
+    for(int s=0;s<STAGES;++s) { totalCount+=count[s];totalBytes+=bytes[s];}
+    std::cout<<"[MeshAlloc] "<<builds<<" builds over "<<sources.size()<<" chunks: "<<(double)totalCount/builds<<" allocs/chunk, "
+        <<totalBytes/1024.0/builds<<" KB/chunk (mesh "<<vertexBytes/1024.0/builds<<" KB/chunk), "
+        <<std::chrono::duration<double,std::milli>(t1-t0).count()/builds<<" ms/chunk"<<std::endl;
+    for(int s=0;s<STAGES;++s)
+        std::cout<<"[MeshAlloc]   "<<names[s]<<": "<<(double)count[s]/builds<<" allocs/chunk, "<<bytes[s]/1024.0/builds<<" KB/chunk"<<std::endl;
+}
+
+//任务系统扩展性基准：用独立的任务系统按不同线程数生成并构建一批独立 chunk（不进入世界），统计每秒完成的 chunk 数
+void World::benchmarkJobScaling() const {
+    const unsigned maxThreads=std::max(1u,std::thread::hardware_concurrency());
+    std::vector<unsigned> counts;
+    for(unsigned t=1;t<maxThreads;t*=2) counts.push_back(t);
+    counts.push_back(maxThreads);
+    //共享任务系统的工作线程仍在跑流式任务时会与独立线程池争抢核心，先等它空闲
+    getJobSystem().waitIdle();
+    double baseRate=0.0;
+    for(unsigned t : counts) {
+        JobSystem jobs(t);
+        const int total=std::max(64,(int)t*16);
+        std::atomic<size_t> vertexCount{0};
+        auto t0=std::chrono::high_resolution_clock::now();
+        for(int i=0;i<total;++i) {
+            //远离玩家的坐标，每个线程数使用不同区域，避免重复生成同一批 chunk
+            int cx=100000+(i%32),cz=100000+(i/32)+(int)t*64;
+            jobs.submit([cx,cz,&vertexCount]() {
+                Chunk chunk(cx,cz);
+                chunk.generateTerrain();
+                MeshSnapshot snapshot;
+                chunk.copyForMeshing(snapshot);
+                MeshData data=Chunk::buildMeshCPU(snapshot);
+                size_t vertices=0;
+                for(auto &v : data.verticesByType) vertices+=v.size();
+                vertexCount+=vertices;
+            });
+        }
+        jobs.waitIdle();
+        auto t1=std::chrono::high_resolution_clock::now();
+        double seconds=std::chrono::duration<double>(t1-t0).count();
+        double rate=seconds>0.0 ? total/seconds : 0.0;
+        if(baseRate==0.0) baseRate=rate;
+        std::cout<<"[JobScaling] threads="<<t<<" chunks="<<total<<" "<<rate<<" chunks/s (speedup "
+            <<(baseRate>0.0 ? rate/baseRate : 0.0)<<"x, steals="<<jobs.getStealCount()
+            <<", verts="<<vertexCount.load()<<")"<<std::endl;
+    }
+}